@@ -1,2 +1,2 @@
-gcc -O3 -fPIC umplot.c -o umplot_linux.umi -shared -static-libgcc -L$PWD -lm -lraylib -lpthread
-
+gcc -O3 umplot_bake_font.c -o umplot_bake_font -L$PWD -lraylib -lGL -lm -lpthread -ldl -lrt -lX11 && ./umplot_bake_font font_atlas.h 12 16 && \
+gcc -O3 -fPIC -DUMPLOT_BAKED_FONT umplot.c -o umplot_linux.umi -shared -static-libgcc -L$PWD -lm -lraylib -lpthread
@@ -0,0 +1 @@
+gcc -O3 -DUMPLOT_NO_UMKA umplot_render.c umplot.c -o umplot_render -L$PWD -lraylib -lGL -lm -lpthread -ldl -lrt -lX11
@@ -0,0 +1 @@
+gcc -O3 -DUMPLOT_NO_UMKA umplot_render.c umplot.c -o umplot_render.exe -static-libgcc -static -lraylib -L. -lopengl32 -lkernel32 -luser32 -lgdi32 -lwinmm -lpthread 
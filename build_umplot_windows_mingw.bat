@@ -1 +1,2 @@
-gcc -O3 -DUMKA_STATIC umplot.c -o umplot_windows.umi -shared -Wl,--dll -static-libgcc -static -lraylib -L. -lkernel32 -luser32 -lgdi32 -lwinmm 
+gcc -O3 umplot_bake_font.c -o umplot_bake_font.exe -static-libgcc -static -lraylib -L. -lopengl32 -lkernel32 -luser32 -lgdi32 -lwinmm -lpthread && umplot_bake_font.exe font_atlas.h 12 16 && ^
+gcc -O3 -DUMKA_STATIC -DUMPLOT_BAKED_FONT umplot.c -o umplot_windows.umi -shared -Wl,--dll -static-libgcc -static -lraylib -L. -lkernel32 -luser32 -lgdi32 -lwinmm -lpthread 
@@ -1,38 +1,38 @@
 #include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
 #include <float.h>
+#include <limits.h>
 #include <math.h>
+#include <pthread.h>
+
+#ifndef _WIN32
+    #include <unistd.h>
+#endif
 
 #include "raylib.h"
-#include "umka_api.h"
+#include "rlgl.h"
 #include "font.h"
+#include "umplot.h"
 
-
-#ifdef _WIN32
-    #define UMPLOT_API __declspec(dllexport)
-#else
-    #define UMPLOT_API __attribute__((visibility("default")))
+#ifndef UMPLOT_NO_UMKA
+    #include "umka_api.h"
 #endif
 
 
-enum
-{
-    STYLE_LINE = 1,
-    STYLE_SCATTER
-};
-
-
-typedef struct 
-{
-    double x, y;
-} Point;
+#ifndef UMPLOT_NO_UMKA
 
+// Umka counterparts of Series and Plot, as declared in umplot.um
 
-typedef struct 
+typedef struct
 {
-    int64_t kind;
-    uint32_t color;
-    double width;
-} Style;
+    UmkaDynArray(double) values;
+    int64_t numCols;
+    double minValue, maxValue;
+} UmkaImageData;
 
 
 typedef struct
@@ -40,485 +40,5907 @@ typedef struct
     UmkaDynArray(Point) points;
     char *name;
     Style style;
-} Series;
+    UmkaImageData image;
+} UmkaSeries;
 
 
 typedef struct
 {
-    int64_t xNumLines, yNumLines;
-    uint32_t color;
-    int64_t fontSize;
-    bool visible, labelled;
-} Grid;
+    UmkaDynArray(UmkaSeries) series;
+    Grid grid;
+    Titles titles;
+    Legend legend;
+    Screenshot screenshot;
+    Fonts fonts;
+    Rendering rendering;
+} UmkaPlot;
 
 
 typedef struct
 {
-    char *x, *y, *graph;
-    uint32_t color;
-    int64_t fontSize;
-    bool visible;
-} Titles;
+    double min, binWidth;
+    UmkaDynArray(int64_t) counts;
+    int64_t underflow, overflow;
+    bool adaptive;
+} UmkaHistogram;
+
+#endif
 
 
 typedef struct
 {
-    bool visible;
-} Legend;
+    double dx, dy;
+    double xScale, yScale;
+} ScreenTransform;
 
 
 typedef struct
 {
-    UmkaDynArray(Series) series;
-    Grid grid;
-    Titles titles;
-    Legend legend;
-} Plot;
+    int frame, numFrames;
+    int64_t window;
+} Animation;
 
 
+// Rasterized fonts are kept for the process lifetime, keyed by size and type. Their textures belong to the current
+// graphics context and are uploaded again after a window has been closed and another one opened
 typedef struct
 {
-    double dx, dy;
-    double xScale, yScale;
-} ScreenTransform;
+    Font font;
+    Image atlas;
+    int type;
+    bool uploaded;
+} CachedFont;
 
 
-static Rectangle getClientRectWithLegend()
-{
-    const int width = GetScreenWidth(), height = GetScreenHeight();
-    return (Rectangle){0.15 * width, 0.05 * height, 0.8 * width, 0.8 * height};
-}
+static CachedFont *fontCache = NULL;
+static int numCachedFonts = 0;
 
 
-static Rectangle getLegendRect(const Plot *plot, UmkaAPI *api)
+// Signed distance field fonts are rasterized once at this size and scaled to any other size by the shader
+enum
 {
-    const int dashLength = 20, margin = 20;
-    Rectangle legendRect = {0};
+    SDF_FONT_SIZE = 48
+};
 
-    if (!plot->legend.visible)
-        return legendRect;
 
-    for (int iSeries = 0; iSeries < api->umkaGetDynArrayLen(&plot->series); iSeries++)
-    {
-        const int labelWidth = MeasureText(plot->series.data[iSeries].name, plot->grid.fontSize);
-        if (labelWidth > legendRect.width)
-            legendRect.width = labelWidth;
-    }
-    
-    legendRect.width += dashLength + 2 * margin;
+static Shader sdfShader;
+static bool sdfShaderLoaded = false;
 
-    const Rectangle clientRectWithLegend = getClientRectWithLegend();
 
-    if (legendRect.width > clientRectWithLegend.width / 2)
-        legendRect.width = clientRectWithLegend.width / 2;
+// The same shader in the GLSL versions of the raylib backends: 330 for OpenGL 3.3+, 300 es for OpenGL ES 3.0, and the 
+// legacy syntax of 120 for OpenGL 2.1 and 100 for OpenGL ES 2.0, where the derivatives need an extension
+#define SDF_SHADER_MAIN \
+    "void main()\n" \
+    "{\n" \
+    "    float dist = SAMPLE(texture0, fragTexCoord).a - 0.5;\n" \
+    "    float delta = max(length(vec2(dFdx(dist), dFdy(dist))), 1e-4);\n" \
+    "    FRAG_COLOR = vec4(fragColor.rgb, fragColor.a * smoothstep(-delta, delta, dist));\n" \
+    "}\n"
 
-    legendRect.height = clientRectWithLegend.height;
-    legendRect.x = clientRectWithLegend.x + clientRectWithLegend.width - legendRect.width;
-    legendRect.y = clientRectWithLegend.y;
+#define SDF_SHADER_MODERN \
+    "#define SAMPLE texture\n" \
+    "#define FRAG_COLOR finalColor\n" \
+    "in vec2 fragTexCoord;\n" \
+    "in vec4 fragColor;\n" \
+    "uniform sampler2D texture0;\n" \
+    "out vec4 finalColor;\n" \
+    SDF_SHADER_MAIN
 
-    return legendRect;
-}
+#define SDF_SHADER_LEGACY \
+    "#define SAMPLE texture2D\n" \
+    "#define FRAG_COLOR gl_FragColor\n" \
+    "varying vec2 fragTexCoord;\n" \
+    "varying vec4 fragColor;\n" \
+    "uniform sampler2D texture0;\n" \
+    SDF_SHADER_MAIN
 
 
-static Rectangle getClientRect(const Plot *plot, UmkaAPI *api)
+static const char *getSdfShaderCode()
 {
-    const Rectangle clientRectWithLegend = getClientRectWithLegend();
-    const Rectangle legendRect = getLegendRect(plot, api);
-
-    Rectangle clientRect = clientRectWithLegend;
-    clientRect.width -= legendRect.width;
-
-    return clientRect;
+    switch (rlGetVersion())
+    {
+        case RL_OPENGL_21:      return "#version 120\n" SDF_SHADER_LEGACY;
+        case RL_OPENGL_ES_20:   return "#version 100\n#extension GL_OES_standard_derivatives : enable\nprecision mediump float;\n" SDF_SHADER_LEGACY;
+        case RL_OPENGL_ES_30:   return "#version 300 es\nprecision mediump float;\n" SDF_SHADER_MODERN;
+        default:                return "#version 330\n" SDF_SHADER_MODERN;
+    }
 }
 
 
-static Vector2 getScreenPoint(const Point point, const ScreenTransform *transform)
-{
-    return (Vector2){transform->xScale * (point.x - transform->dx), transform->yScale * (point.y - transform->dy)};
-}
+#ifdef UMPLOT_BAKED_FONT
 
+// Atlases pre-rasterized at build time by umplot_bake_font
 
-static Point getGraphPoint(const Vector2 point, const ScreenTransform *transform)
+typedef struct
 {
-    return (Point){point.x / transform->xScale + transform->dx, point.y / transform->yScale + transform->dy};
-}
+    int value, offsetX, offsetY, advanceX;
+    int x, y, width, height;
+} BakedGlyph;
 
 
-static void setTransformToMinMax(const Plot *plot, ScreenTransform *transform, const Point *minPt, const Point *maxPt, UmkaAPI *api)
+typedef struct
 {
-    Rectangle rect = getClientRect(plot, api);
+    int size, glyphCount, glyphPadding;
+    int atlasWidth, atlasHeight;
+    int encodedSize;
+    const unsigned char *atlas;
+    const BakedGlyph *glyphs;
+} BakedFont;
 
-    transform->xScale = (maxPt->x > minPt->x) ?  (rect.width  / (maxPt->x - minPt->x)) : 1.0;
-    transform->yScale = (maxPt->y > minPt->y) ? -(rect.height / (maxPt->y - minPt->y)) : 1.0; 
 
-    transform->dx = minPt->x - rect.x / transform->xScale;
-    transform->dy = maxPt->y - rect.y / transform->yScale;
-}
+#include "font_atlas.h"
 
 
-static void resetTransform(const Plot *plot, ScreenTransform *transform, UmkaAPI *api)
+static bool getBakedFont(int size, Font *font, Image *atlas)
 {
-    Point minPt = (Point){ DBL_MAX,  DBL_MAX};
-    Point maxPt = (Point){-DBL_MAX, -DBL_MAX};
+    const BakedFont *baked = NULL;
 
-    for (int iSeries = 0; iSeries < api->umkaGetDynArrayLen(&plot->series); iSeries++)
-    {
-        Series *series = &plot->series.data[iSeries];
-        for (int iPt = 0; iPt < api->umkaGetDynArrayLen(&series->points); iPt++)
+    for (int i = 0; i < (int)(sizeof(bakedFonts) / sizeof(bakedFonts[0])); i++)
+        if (bakedFonts[i].size == size)
         {
-            const Point *pt = &series->points.data[iPt];
-            if (pt->x > maxPt.x)  maxPt.x = pt->x;
-            if (pt->x < minPt.x)  minPt.x = pt->x;
-            if (pt->y > maxPt.y)  maxPt.y = pt->y;
-            if (pt->y < minPt.y)  minPt.y = pt->y;
+            baked = &bakedFonts[i];
+            break;
         }
+
+    if (!baked)
+        return false;
+
+    *font = (Font){.baseSize = size, .glyphCount = baked->glyphCount, .glyphPadding = baked->glyphPadding};
+    font->glyphs = MemAlloc(baked->glyphCount * sizeof(GlyphInfo));
+    font->recs = MemAlloc(baked->glyphCount * sizeof(Rectangle));
+
+    for (int i = 0; i < baked->glyphCount; i++)
+    {
+        const BakedGlyph *glyph = &baked->glyphs[i];
+        font->glyphs[i] = (GlyphInfo){.value = glyph->value, .offsetX = glyph->offsetX, .offsetY = glyph->offsetY, .advanceX = glyph->advanceX};
+        font->recs[i] = (Rectangle){glyph->x, glyph->y, glyph->width, glyph->height};
     }
 
-    setTransformToMinMax(plot, transform, &minPt, &maxPt, api);
-}
+    // White gray-alpha pixels with the decoded alpha: zero bytes are followed by a run length
+    const int numPixels = baked->atlasWidth * baked->atlasHeight;
+    unsigned char *pixels = MemAlloc(2 * numPixels);
 
+    for (int iByte = 0, iPixel = 0; iByte < baked->encodedSize && iPixel < numPixels; iByte++)
+    {
+        const int alpha = baked->atlas[iByte];
+        const int run = (alpha == 0) ? baked->atlas[++iByte] : 1;
 
-static void resizeTransform(const Plot *plot, ScreenTransform *transform, const Rectangle *rect, UmkaAPI *api)
-{
-    const Point minPt = getGraphPoint((Vector2){rect->x, rect->y + rect->height}, transform);
-    const Point maxPt = getGraphPoint((Vector2){rect->x + rect->width, rect->y}, transform);
+        for (int i = 0; i < run && iPixel < numPixels; i++, iPixel++)
+        {
+            pixels[2 * iPixel] = 255;
+            pixels[2 * iPixel + 1] = alpha;
+        }
+    }
 
-    setTransformToMinMax(plot, transform, &minPt, &maxPt, api);
+    *atlas = (Image){pixels, baked->atlasWidth, baked->atlasHeight, 1, PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA};
+    return true;
 }
 
+#endif
 
-static void panTransform(const Plot *plot, ScreenTransform *transform, const Vector2 *delta)
+
+static Font getFont(int size, bool sdf)
 {
-    transform->dx -= delta->x / transform->xScale;
-    transform->dy -= delta->y / transform->yScale;
-}
+    const int type = sdf ? FONT_SDF : FONT_DEFAULT;
+    if (sdf)
+        size = SDF_FONT_SIZE;
 
+    CachedFont *cached = NULL;
 
-static void zoomTransform(const Plot *plot, ScreenTransform *transform, const Rectangle *zoomRect, UmkaAPI *api)
-{
-    if (zoomRect->width == 0 && zoomRect->height == 0)
-        return;
+    for (int i = 0; i < numCachedFonts; i++)
+        if (fontCache[i].font.baseSize == size && fontCache[i].type == type)
+        {
+            cached = &fontCache[i];
+            break;
+        }
 
-    if (zoomRect->width < 0 || zoomRect->height < 0)
+    if (!cached)
     {
-        resetTransform(plot, transform, api);
-        return;
-    }
+        CachedFont *cache = realloc(fontCache, (numCachedFonts + 1) * sizeof(CachedFont));
+        if (!cache)
+            return GetFontDefault();
 
-    resizeTransform(plot, transform, zoomRect, api);
-}
+        fontCache = cache;
+        cached = &fontCache[numCachedFonts++];
 
+        // Baked atlas if there is one for this size, otherwise the same steps as LoadFontFromMemory(), except the texture upload
+        const int glyphCount = 256, glyphPadding = sdf ? 0 : 4;
 
-static void drawGraph(const Plot *plot, const ScreenTransform *transform, UmkaAPI *api)
-{
-    Rectangle clientRect = getClientRect(plot, api);
-    BeginScissorMode(clientRect.x, clientRect.y, clientRect.width, clientRect.height);
+        *cached = (CachedFont){.font = {.baseSize = size, .glyphCount = glyphCount, .glyphPadding = glyphPadding}, .type = type};
 
-    for (int iSeries = 0; iSeries < api->umkaGetDynArrayLen(&plot->series); iSeries++)
-    {
-        Series *series = &plot->series.data[iSeries];
-        switch (series->style.kind)
+#ifdef UMPLOT_BAKED_FONT
+        if (sdf || !getBakedFont(size, &cached->font, &cached->atlas))
+#endif
         {
-            case STYLE_LINE:
-            {
-                if (api->umkaGetDynArrayLen(&series->points) > 1)
-                {
-                    Vector2 prevPt = getScreenPoint(series->points.data[0], transform);                
-                    
-                    for (int iPt = 1; iPt < api->umkaGetDynArrayLen(&series->points); iPt++)
-                    {
-                        Vector2 pt = getScreenPoint(series->points.data[iPt], transform); 
-                        DrawLineEx(prevPt, pt, series->style.width, *(Color *)&series->style.color);
-                        prevPt = pt;
-                    }
-                }                
-                break;
-            }
+            cached->font.glyphs = LoadFontData(liberationFont, sizeof(liberationFont), size, NULL, glyphCount, type);
+            cached->atlas = GenImageFontAtlas(cached->font.glyphs, &cached->font.recs, glyphCount, size, glyphPadding, sdf ? 1 : 0);
+        }
+    }
 
-            case STYLE_SCATTER:
-            {
-                for (int iPt = 0; iPt < api->umkaGetDynArrayLen(&series->points); iPt++)
-                {
-                    Vector2 pt = getScreenPoint(series->points.data[iPt], transform); 
-                    DrawCircleV(pt, series->style.width, *(Color *)&series->style.color);
-                }
-                break;
-            }
+    if (!cached->uploaded)
+    {
+        cached->font.texture = LoadTextureFromImage(cached->atlas);
+        cached->uploaded = true;
 
-            default: break;
-        }
+        if (sdf)
+            SetTextureFilter(cached->font.texture, TEXTURE_FILTER_BILINEAR);
     }
 
-    EndScissorMode();    
+    if (sdf && !sdfShaderLoaded)
+    {
+        sdfShader = LoadShaderFromMemory(NULL, getSdfShaderCode());
+        sdfShaderLoaded = true;
+    }
+
+    return cached->font;
 }
 
 
-static void drawGrid(const Plot *plot, const ScreenTransform *transform, const Font *font, int *maxYLabelWidth, UmkaAPI *api)
+static void releaseFonts()
 {
-    if (maxYLabelWidth)
-        *maxYLabelWidth = 0;
+    for (int i = 0; i < numCachedFonts; i++)
+        if (fontCache[i].uploaded)
+        {
+            UnloadTexture(fontCache[i].font.texture);
+            fontCache[i].uploaded = false;
+        }
 
-    if (plot->grid.xNumLines <= 0 || plot->grid.yNumLines <= 0)
-        return;
+    if (sdfShaderLoaded)
+    {
+        UnloadShader(sdfShader);
+        sdfShaderLoaded = false;
+    }
+}
 
-    const Rectangle clientRect = getClientRect(plot, api);
 
-    const double xSpan =  clientRect.width  / transform->xScale;
-    const double ySpan = -clientRect.height / transform->yScale;
+// Counts the graphics contexts closed so far. Textures cached with plots remember the context they were uploaded to, 
+// since closing a window destroys its textures
+static int64_t numClosedContexts = 0;
 
-    double xStep = pow(10.0, floor(log10(xSpan / plot->grid.xNumLines)));
-    double yStep = pow(10.0, floor(log10(ySpan / plot->grid.yNumLines)));
 
-    while (xSpan / xStep > 2.0 * plot->grid.xNumLines)
-        xStep *= 2.0;
+static void closeWindow()
+{
+    releaseFonts();
+    numClosedContexts++;
+    CloseWindow();
+}
 
-    while (ySpan / yStep > 2.0 * plot->grid.yNumLines)
-        yStep *= 2.0;    
 
-    const Point minPt   = getGraphPoint((Vector2){clientRect.x, clientRect.y + clientRect.height}, transform);
-    const Point startPt = (Point){ceil(minPt.x / xStep) * xStep, ceil(minPt.y / yStep) * yStep};
+// Must be called between beginText() and endText()
+static void drawText(const Plot *plot, const Font *font, const char *text, Vector2 pos, float rotation, int64_t fontSize, uint32_t color)
+{
+    if (rotation != 0)
+        DrawTextPro(*font, text, pos, (Vector2){0, 0}, rotation, fontSize, 1, *(Color *)&color);
+    else
+        DrawTextEx(*font, text, pos, fontSize, 1, *(Color *)&color);
+}
 
-    Vector2 startPtScreen = getScreenPoint(startPt, transform);
 
-    // Vertical grid
-    for (int i = 0, x = startPtScreen.x; x < clientRect.x + clientRect.width; i++, x = startPtScreen.x + i * xStep * transform->xScale)
-    {
-        // Line
-        if (plot->grid.visible)
-            DrawLineEx((Vector2){x, clientRect.y}, (Vector2){x, clientRect.y + clientRect.height}, 1, *(Color *)&plot->grid.color);
+// Switching shaders flushes the batch, so the SDF shader is enabled once for a whole pass of text rather than for each 
+// label. Shapes drawn within the pass are unaffected: they sample the opaque white shapes texture, which the shader 
+// leaves opaque
+static void beginText(const Plot *plot)
+{
+    if (plot->fonts.sdf && sdfShaderLoaded)
+        BeginShaderMode(sdfShader);
+}
 
-        // Label
-        if (plot->grid.labelled)
-        {
-            const char *label = TextFormat((xStep > 0.01) ? "%.2f" : "%.4f", startPt.x + i * xStep);
-            const int labelWidth = MeasureTextEx(*font, label, plot->grid.fontSize, 1).x;
 
-            const int labelX = x - labelWidth / 2;
-            const int labelY = clientRect.y + clientRect.height + plot->grid.fontSize;
+static void endText(const Plot *plot)
+{
+    if (plot->fonts.sdf && sdfShaderLoaded)
+        EndShaderMode();
+}
 
-            DrawTextEx(*font, label, (Vector2){labelX, labelY}, plot->grid.fontSize, 1, *(Color *)&plot->grid.color);            
-        }
-    }
 
-    // Horizontal grid
-    for (int j = 0, y = startPtScreen.y; y > clientRect.y; j++, y = startPtScreen.y + j * yStep * transform->yScale)
-    {
-        // Line
-        if (plot->grid.visible)
-            DrawLineEx((Vector2){clientRect.x, y}, (Vector2){clientRect.x + clientRect.width, y}, 1, *(Color *)&plot->grid.color);
+// Area the plot is laid out in: the window or an offscreen target
+static Rectangle canvas;
 
-        // Label
-        if (plot->grid.labelled)
-        {
-            const char *label = TextFormat((yStep > 0.01) ? "%.2f" : "%.4f", startPt.y + j * yStep);
-            const int labelWidth = MeasureTextEx(*font, label, plot->grid.fontSize, 1).x;
+// Hidden window kept open between offscreen renders to provide a graphics context
+static bool offscreen = false;
 
-            const int labelX = clientRect.x - labelWidth - plot->grid.fontSize;
-            const int labelY = y - plot->grid.fontSize / 2;
 
-            DrawTextEx(*font, label, (Vector2){labelX, labelY}, plot->grid.fontSize, 1, *(Color *)&plot->grid.color);
+static void beginOffscreen()
+{
+    if (offscreen)
+        return;
 
-            if (maxYLabelWidth && labelWidth > *maxYLabelWidth)
-                *maxYLabelWidth = labelWidth;                       
-        }
-    }
+    SetTraceLogLevel(LOG_ERROR);
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(1, 1, "UmPlot");
+    offscreen = true;
 }
 
 
-static void drawTitles(const Plot *plot, const ScreenTransform *transform, const Font *font, int maxYLabelWidth, UmkaAPI *api)
+static void endOffscreen()
 {
-    if (!plot->titles.visible)
+    if (!offscreen)
         return;
 
-    Rectangle clientRect = getClientRect(plot, api);
-
-    // Horizontal axis
-    if (plot->titles.x && TextLength(plot->titles.x) > 0)
-    {
-        const int titleWidth = MeasureTextEx(*font, plot->titles.x, plot->titles.fontSize, 1).x;
+    closeWindow();
+    offscreen = false;
+}
 
-        const int titleX = clientRect.x + clientRect.width / 2 - titleWidth / 2;
-        const int titleY = clientRect.y + clientRect.height + 2 * plot->grid.fontSize + plot->titles.fontSize;
 
-        DrawTextEx(*font, plot->titles.x, (Vector2){titleX, titleY}, plot->titles.fontSize, 1, *(Color *)&plot->titles.color);
-    }
+enum
+{
+    MAX_PENDING_SCREENSHOTS = 8,
+    MAX_SCREENSHOT_FILE_NAME = 256
+};
 
-    // Vertical axis
-    if (plot->titles.y && TextLength(plot->titles.y) > 0)
-    {
-        const int titleWidth = MeasureTextEx(*font, plot->titles.y, plot->titles.fontSize, 1).x;
 
-        const int titleX = clientRect.x - 2 * plot->grid.fontSize - plot->titles.fontSize - maxYLabelWidth;
-        const int titleY = clientRect.y + clientRect.height / 2 + titleWidth / 2;
+typedef struct
+{
+    Image image;
+    char fileName[MAX_SCREENSHOT_FILE_NAME];
+} PendingScreenshot;
 
-        DrawTextPro(*font, plot->titles.y, (Vector2){titleX, titleY}, (Vector2){0, 0}, -90.0, plot->titles.fontSize, 1, *(Color *)&plot->titles.color);
-    }
 
-    // Graph
-    if (plot->titles.graph && TextLength(plot->titles.graph) > 0)
-    {
-        const int titleWidth = MeasureTextEx(*font, plot->titles.graph, plot->titles.fontSize, 1).x;
+// Screenshots are encoded and written by a worker thread, so that the window never waits for PNG compression
+typedef struct
+{
+    PendingScreenshot pending[MAX_PENDING_SCREENSHOTS];
+    int first, count;
+    bool running, stopping;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+} ScreenshotWriter;
 
-        const int titleX = clientRect.x + clientRect.width / 2 - titleWidth / 2;
-        const int titleY = clientRect.y - 2 * plot->titles.fontSize;
 
-        DrawTextEx(*font, plot->titles.graph, (Vector2){titleX, titleY}, plot->titles.fontSize, 1, *(Color *)&plot->titles.color);
-    }        
-}
+static ScreenshotWriter screenshotWriter = {.mutex = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER};
 
 
-static void drawLegend(const Plot *plot, const Font *font, UmkaAPI *api)
+static void *screenshotWriterThread(void *arg)
 {
-    if (!plot->legend.visible)
-        return;    
+    ScreenshotWriter *writer = (ScreenshotWriter *)arg;
 
-    const int dashLength = 20, margin = 20;
-
-    const Rectangle legendRect = getLegendRect(plot, api);
+    pthread_mutex_lock(&writer->mutex);
 
-    for (int iSeries = 0; iSeries < api->umkaGetDynArrayLen(&plot->series); iSeries++)
+    while (true)
     {
-        Series *series = &plot->series.data[iSeries];
-        
-        // Legend mark
-        switch (series->style.kind)
-        {
-            case STYLE_LINE:
-            {
-                Vector2 dashPt1 = (Vector2){legendRect.x + margin, legendRect.y + plot->grid.fontSize / 2 + iSeries * (plot->grid.fontSize + margin)};
-                Vector2 dashPt2 = dashPt1;
-                dashPt2.x += dashLength;
-
-                DrawLineEx(dashPt1, dashPt2, series->style.width, *(Color *)&series->style.color);
-                break;
-            }
-
-            case STYLE_SCATTER:
-            {
-                Vector2 pt = (Vector2){legendRect.x + margin + dashLength / 2, legendRect.y + plot->grid.fontSize / 2 + iSeries * (plot->grid.fontSize + margin)};
+        while (writer->count == 0 && !writer->stopping)
+            pthread_cond_wait(&writer->cond, &writer->mutex);
 
-                DrawCircleV(pt, series->style.width, *(Color *)&series->style.color);
-                break;
-            }
+        if (writer->count == 0)
+            break;
 
-            default: break;
-        }
+        PendingScreenshot screenshot = writer->pending[writer->first];
+        writer->first = (writer->first + 1) % MAX_PENDING_SCREENSHOTS;
+        writer->count--;
 
-        // Legend text
-        const int labelX = legendRect.x + dashLength + 2 * margin;
-        const int labelY = legendRect.y + iSeries * (plot->grid.fontSize + margin);
+        pthread_mutex_unlock(&writer->mutex);
 
-        DrawTextEx(*font, series->name, (Vector2){labelX, labelY}, plot->grid.fontSize, 1, *(Color *)&plot->grid.color);  
+        ExportImage(screenshot.image, screenshot.fileName);
+        UnloadImage(screenshot.image);
 
+        pthread_mutex_lock(&writer->mutex);
     }
+
+    pthread_mutex_unlock(&writer->mutex);
+    return NULL;
 }
 
 
-static void drawZoomRect(Rectangle zoomRect, const ScreenTransform *transform)
+static bool queueScreenshot(ScreenshotWriter *writer, Image image, const char *fileName)
 {
-    if (zoomRect.width < 0)
+    pthread_mutex_lock(&writer->mutex);
+
+    if (!writer->running)
     {
-        zoomRect.x += zoomRect.width;
-        zoomRect.width *= -1;
+        writer->stopping = false;
+        writer->running = pthread_create(&writer->thread, NULL, screenshotWriterThread, writer) == 0;
     }
-    if (zoomRect.height < 0)
+
+    // Drop the screenshot rather than stall the window if the writer cannot keep up
+    const bool queued = writer->running && writer->count < MAX_PENDING_SCREENSHOTS;
+
+    if (queued)
     {
-        zoomRect.y += zoomRect.height;
-        zoomRect.height *= -1;
+        PendingScreenshot *screenshot = &writer->pending[(writer->first + writer->count) % MAX_PENDING_SCREENSHOTS];
+        screenshot->image = image;
+        TextCopy(screenshot->fileName, fileName);
+        writer->count++;
+
+        pthread_cond_signal(&writer->cond);
     }
 
-    DrawRectangleLinesEx(zoomRect, 1, GRAY);
+    pthread_mutex_unlock(&writer->mutex);
+
+    if (!queued)
+        UnloadImage(image);
+
+    return queued;
 }
 
 
-UMPLOT_API void umplot_plot(UmkaStackSlot *params, UmkaStackSlot *result)
+static void finishScreenshots(ScreenshotWriter *writer)
 {
-    Plot *plot = (Plot *) params[0].ptrVal;
+    pthread_mutex_lock(&writer->mutex);
 
-    void *umka = result->ptrVal;
-    UmkaAPI *api = umkaGetAPI(umka);
+    const bool running = writer->running;
+    writer->stopping = true;
+    pthread_cond_signal(&writer->cond);
 
-    SetTraceLogLevel(LOG_ERROR);
-    SetConfigFlags(FLAG_WINDOW_RESIZABLE);
+    pthread_mutex_unlock(&writer->mutex);
+
+    // Pending screenshots are still written before the thread exits
+    if (running)
+        pthread_join(writer->thread, NULL);
+
+    writer->running = false;
+}
+
+
+enum
+{
+    MAX_THREADS = 32
+};
+
+
+typedef void (*ParallelFunc)(void *data, int64_t first, int64_t last);
+
+
+typedef struct
+{
+    ParallelFunc func;
+    void *data;
+    int64_t first, last;
+} ParallelTask;
+
+
+static int getNumThreads()
+{
+#ifdef _WIN32
+    int numThreads = pthread_num_processors_np();
+#else
+    int numThreads = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+    if (numThreads < 1)            numThreads = 1;
+    if (numThreads > MAX_THREADS)  numThreads = MAX_THREADS;
+    return numThreads;
+}
+
+
+static void *parallelTaskThread(void *arg)
+{
+    ParallelTask *task = (ParallelTask *)arg;
+    task->func(task->data, task->first, task->last);
+    return NULL;
+}
+
+
+// Splits [0, count) into contiguous ranges of at least minCount items and processes them on all cores
+static void parallelFor(int64_t count, int64_t minCount, ParallelFunc func, void *data)
+{
+    int64_t numTasks = getNumThreads();
+    if (minCount > 0 && count / minCount < numTasks)
+        numTasks = count / minCount;
+
+    if (numTasks <= 1)
+    {
+        if (count > 0)
+            func(data, 0, count);
+        return;
+    }
+
+    ParallelTask tasks[MAX_THREADS];
+    pthread_t threads[MAX_THREADS];
+    bool started[MAX_THREADS];
+
+    for (int iTask = 0; iTask < numTasks; iTask++)
+        tasks[iTask] = (ParallelTask){func, data, count * iTask / numTasks, count * (iTask + 1) / numTasks};
+
+    // The calling thread takes the last range, and any range whose thread could not be started
+    for (int iTask = 0; iTask < numTasks - 1; iTask++)
+        started[iTask] = pthread_create(&threads[iTask], NULL, parallelTaskThread, &tasks[iTask]) == 0;
+
+    func(data, tasks[numTasks - 1].first, tasks[numTasks - 1].last);
+
+    for (int iTask = 0; iTask < numTasks - 1; iTask++)
+    {
+        if (started[iTask])
+            pthread_join(threads[iTask], NULL);
+        else
+            func(data, tasks[iTask].first, tasks[iTask].last);
+    }
+}
+
+
+static Rectangle getClientRectWithLegend()
+{
+    return (Rectangle){canvas.x + 0.15 * canvas.width, canvas.y + 0.05 * canvas.height, 0.8 * canvas.width, 0.8 * canvas.height};
+}
+
+
+typedef struct
+{
+    const char *name;       // Name and style the legend rows were built for
+    int64_t kind;
+    uint32_t color;
+} LegendEntry;
+
+
+// Legend row: a single series, or a group of consecutive series with equal names and styles
+typedef struct
+{
+    int64_t firstSeries, numSeries;
+    char *label;            // "name (count)" for groups, NULL for single series
+    float labelWidth;
+} LegendRow;
+
+
+// Spatial index for point queries, built lazily for each series
+typedef struct
+{
+    const Point *points;        // Data the index was built for
+    int64_t numPoints;
+    bool built, sorted;         // Sorted series are searched by x, others through a uniform grid
+    double minY, maxY;
+
+    int cols, rows;
+    double gridMinX, gridMinY, cellWidth, cellHeight;
+    int64_t *cellStarts;        // cols * rows + 1 offsets into cellPoints
+    int64_t *cellPoints;        // Point indices bucketed by cell
+    double *cellMinY, *cellMaxY;
+
+    double *prefixY;            // numPoints + 1 prefix sums of y, in point order for sorted series and in cellPoints order otherwise
+} SeriesIndex;
+
+
+typedef struct
+{
+    double minY, maxY;
+} MinMax;
+
+
+enum
+{
+    PYRAMID_BASE_LEVEL = 4,         // The finest level has blocks of 2^PYRAMID_BASE_LEVEL points
+    MAX_PYRAMID_LEVELS = 64 - PYRAMID_BASE_LEVEL,
+    LOD_MIN_POINTS_PER_PIXEL = 4    // Denser visible ranges are drawn from the pyramid
+};
+
+
+// Level-of-detail pyramid of a series sorted by x: level i holds the y range of every block of 2^(PYRAMID_BASE_LEVEL + i) 
+// points, the last block of a level may be partial
+typedef struct
+{
+    const Point *points;            // Data the pyramid was built for
+    int64_t numPoints;
+    Point firstPt, lastPt;          // Used to recognize appended data in a reallocated array
+    bool built, sorted;
+
+    int numLevels;
+    MinMax *levels[MAX_PYRAMID_LEVELS];
+    int64_t levelCapacities[MAX_PYRAMID_LEVELS];
+} SeriesPyramid;
+
+
+// Image of a series rendered on the CPU for a given view, such as a density map
+typedef struct
+{
+    ScreenTransform transform;      // View the image was rendered for
+    Rectangle rect;
+    const Point *points;
+    int64_t firstPt, lastPt;
+    bool valid;
+
+    Color *pixels;
+    Texture2D texture;
+    int64_t context;                // Number of closed contexts when the texture was uploaded
+} SeriesRaster;
+
+
+// Range of points of a series
+typedef struct
+{
+    const Point *points;
+    int64_t firstPt, lastPt;
+} PointSpan;
+
+
+// Image series converted to colors and uploaded in tiles that fit into a texture each
+typedef struct
+{
+    const double *values;           // Data the tiles were converted from
+    int64_t numRows, numCols;
+    double minValue, maxValue;
+
+    Texture2D *tiles;               // numTileRows * numTileCols, row by row
+    int numTileRows, numTileCols;
+    int64_t context;                // Number of closed contexts when the tiles were uploaded
+} SeriesImage;
+
+
+// Sparkline of a series reduced to a single pixel column, with y normalized to the series range
+typedef struct
+{
+    float minY, maxY, firstY, lastY;
+    bool empty;
+} SparklineColumn;
+
+
+enum
+{
+    FINGERPRINT_SAMPLES = 8
+};
+
+
+// Cheap summary of the data of a series: evenly spaced samples of the points and image values, enough to tell
+// unchanged or appended data from data replaced in a reused array
+typedef struct
+{
+    int64_t numPoints;
+    Point points[FINGERPRINT_SAMPLES];
+    int64_t numValues;
+    double values[FINGERPRINT_SAMPLES];
+} SeriesFingerprint;
+
+
+// Points inside the last box selection
+typedef struct
+{
+    int64_t *indices;
+    int64_t numIndices;
+    double sum, min, max;
+} SeriesSelection;
+
+
+struct PlotCache
+{
+    SeriesIndex *seriesIndices;
+    int64_t numSeriesIndices;
+
+    SeriesPyramid *seriesPyramids;
+    int64_t numSeriesPyramids;
+
+    SeriesRaster *seriesRasters;
+    int64_t numSeriesRasters;
+
+    SeriesImage *seriesImages;
+    int64_t numSeriesImages;
+
+    SeriesRaster lineDensityRaster;         // All series with the line density style accumulated together
+    PointSpan *lineDensitySpans;            // Data the line density raster was rendered for
+    int64_t numLineDensitySpans;
+
+    SparklineColumn *sparklineColumns;      // numSparklineColumns for each series
+    MinMax *sparklineRanges;
+    PointSpan *sparklineSpans;              // Data the columns were built for, lastPt < 0 if not built
+    int64_t numSparklineSeries;
+    int numSparklineColumns;
+
+    SeriesFingerprint *fingerprints;        // Data the cache was last checked against, one for each series
+    int64_t numFingerprints;
+
+    LegendEntry *legendEntries;
+    int64_t numLegendEntries;
+    const Series *legendSeries;             // Series array and call the legend entries were last checked for
+    int64_t legendCall;
+    LegendRow *legendRows;
+    int64_t numLegendRows;
+    const GlyphInfo *legendFontGlyphs;
+    int64_t legendFontSize;
+    bool legendGrouped;
+    float maxLabelWidth;
+    float legendScroll;
+};
+
+
+// Counts the calls of the API functions that take plots. Plots cannot change during a call, so data derived from them
+// only needs to be checked against them once per call
+static int64_t numPlotCalls = 0;
+
+
+static PlotCache *getPlotCache(const Plot *plot)
+{
+    // The cache holds derived state only, so it can be attached to a plot passed as const
+    Plot *mutablePlot = (Plot *)plot;
+
+    if (!mutablePlot->cache)
+        mutablePlot->cache = calloc(1, sizeof(PlotCache));
+
+    return mutablePlot->cache;
+}
+
+
+static void freeSeriesIndex(SeriesIndex *index)
+{
+    free(index->cellStarts);
+    free(index->cellPoints);
+    free(index->cellMinY);
+    free(index->cellMaxY);
+    free(index->prefixY);
+    *index = (SeriesIndex){0};
+}
+
+
+static void freeSeriesPyramid(SeriesPyramid *pyramid)
+{
+    for (int iLevel = 0; iLevel < pyramid->numLevels; iLevel++)
+        free(pyramid->levels[iLevel]);
+    *pyramid = (SeriesPyramid){0};
+}
+
+
+static void freeSeriesRaster(SeriesRaster *raster)
+{
+    // Textures of a closed window are already gone
+    if (raster->texture.id != 0 && raster->context == numClosedContexts && IsWindowReady())
+        UnloadTexture(raster->texture);
+
+    free(raster->pixels);
+    *raster = (SeriesRaster){0};
+}
+
+
+static void freeSeriesImage(SeriesImage *image)
+{
+    // Textures of a closed window are already gone
+    if (image->context == numClosedContexts && IsWindowReady())
+        for (int i = 0; i < image->numTileRows * image->numTileCols; i++)
+            if (image->tiles[i].id != 0)
+                UnloadTexture(image->tiles[i]);
+
+    free(image->tiles);
+    *image = (SeriesImage){0};
+}
+
+
+static void freeLegendRows(PlotCache *cache)
+{
+    for (int iRow = 0; iRow < cache->numLegendRows; iRow++)
+        free(cache->legendRows[iRow].label);
+
+    free(cache->legendRows);
+    cache->legendRows = NULL;
+    cache->numLegendRows = 0;
+}
+
+
+static void freePlotCache(PlotCache *cache)
+{
+    if (!cache)
+        return;
+
+    for (int iSeries = 0; iSeries < cache->numSeriesIndices; iSeries++)
+        freeSeriesIndex(&cache->seriesIndices[iSeries]);
+    free(cache->seriesIndices);
+
+    for (int iSeries = 0; iSeries < cache->numSeriesPyramids; iSeries++)
+        freeSeriesPyramid(&cache->seriesPyramids[iSeries]);
+    free(cache->seriesPyramids);
+
+    for (int iSeries = 0; iSeries < cache->numSeriesRasters; iSeries++)
+        freeSeriesRaster(&cache->seriesRasters[iSeries]);
+    free(cache->seriesRasters);
+
+    for (int iSeries = 0; iSeries < cache->numSeriesImages; iSeries++)
+        freeSeriesImage(&cache->seriesImages[iSeries]);
+    free(cache->seriesImages);
+
+    freeSeriesRaster(&cache->lineDensityRaster);
+    free(cache->lineDensitySpans);
+
+    free(cache->sparklineColumns);
+    free(cache->sparklineRanges);
+    free(cache->sparklineSpans);
+
+    free(cache->fingerprints);
+
+    freeLegendRows(cache);
+    free(cache->legendEntries);
+    free(cache);
+}
+
+
+static int64_t getFingerprintSample(int64_t num, int iSample)
+{
+    return (num - 1) * iSample / (FINGERPRINT_SAMPLES - 1);
+}
+
+
+static void getSeriesFingerprint(const Series *series, SeriesFingerprint *fingerprint)
+{
+    *fingerprint = (SeriesFingerprint){
+        .numPoints = series->numPoints,
+        .numValues = (series->image.values && series->image.numRows > 0 && series->image.numCols > 0) ? series->image.numRows * series->image.numCols : 0
+    };
+
+    if (fingerprint->numPoints > 0)
+        for (int i = 0; i < FINGERPRINT_SAMPLES; i++)
+            fingerprint->points[i] = series->points[getFingerprintSample(fingerprint->numPoints, i)];
+
+    if (fingerprint->numValues > 0)
+        for (int i = 0; i < FINGERPRINT_SAMPLES; i++)
+            fingerprint->values[i] = series->image.values[getFingerprintSample(fingerprint->numValues, i)];
+}
+
+
+// Points are kept if they are the same or have only been appended to, i.e. the old samples are still in place
+static bool hasSamePoints(const SeriesFingerprint *fingerprint, const Series *series)
+{
+    if (series->numPoints < fingerprint->numPoints)
+        return false;
+
+    for (int i = 0; fingerprint->numPoints > 0 && i < FINGERPRINT_SAMPLES; i++)
+        if (memcmp(&series->points[getFingerprintSample(fingerprint->numPoints, i)], &fingerprint->points[i], sizeof(Point)) != 0)
+            return false;
+
+    return true;
+}
+
+
+static bool hasSameValues(const SeriesFingerprint *fingerprint, const SeriesFingerprint *current)
+{
+    return fingerprint->numValues == current->numValues && memcmp(fingerprint->values, current->values, sizeof(fingerprint->values)) == 0;
+}
+
+
+static void invalidateSeriesPoints(PlotCache *cache, int64_t iSeries)
+{
+    if (iSeries < cache->numSeriesIndices)
+        freeSeriesIndex(&cache->seriesIndices[iSeries]);
+
+    if (iSeries < cache->numSeriesPyramids)
+        freeSeriesPyramid(&cache->seriesPyramids[iSeries]);
+
+    if (iSeries < cache->numSeriesRasters)
+        freeSeriesRaster(&cache->seriesRasters[iSeries]);
+
+    cache->lineDensityRaster.valid = false;
+
+    if (iSeries < cache->numSparklineSeries)
+        cache->sparklineSpans[iSeries].lastPt = -1;
+}
+
+
+// The series may have been changed or replaced since the last call, possibly by new arrays allocated at the addresses
+// of the old ones, so the derived data of each series whose samples have changed is dropped
+static void checkPlotCache(const Plot *plot)
+{
+    // The cache is created before anything is derived, so that all its data are covered by the fingerprints
+    PlotCache *cache = getPlotCache(plot);
+    if (!cache)
+        return;
+
+    bool known = cache->numFingerprints == plot->numSeries;
+
+    if (!known)
+    {
+        free(cache->fingerprints);
+        cache->fingerprints = calloc(plot->numSeries > 0 ? plot->numSeries : 1, sizeof(SeriesFingerprint));
+        cache->numFingerprints = cache->fingerprints ? plot->numSeries : 0;
+    }
+
+    for (int64_t iSeries = 0; iSeries < cache->numFingerprints; iSeries++)
+    {
+        SeriesFingerprint *fingerprint = &cache->fingerprints[iSeries];
+        const Series *series = &plot->series[iSeries];
+
+        SeriesFingerprint current;
+        getSeriesFingerprint(series, &current);
+
+        // Without a fingerprint nothing derived from the series can be trusted
+        if (!known || !hasSamePoints(fingerprint, series))
+            invalidateSeriesPoints(cache, iSeries);
+
+        if ((!known || !hasSameValues(fingerprint, &current)) && iSeries < cache->numSeriesImages)
+            freeSeriesImage(&cache->seriesImages[iSeries]);
+
+        *fingerprint = current;
+    }
+}
+
+
+// Called by the API functions that take plots before using their caches
+static void beginPlotCall(const Plot *plots, int numPlots)
+{
+    numPlotCalls++;
+
+    for (int iPlot = 0; iPlot < numPlots; iPlot++)
+        checkPlotCache(&plots[iPlot]);
+}
+
+
+static bool isSameLegendEntry(const Series *series1, const Series *series2)
+{
+    return series1->style.kind == series2->style.kind && series1->style.color == series2->style.color &&
+           (series1->name == series2->name || (series1->name && series2->name && strcmp(series1->name, series2->name) == 0));
+}
+
+
+static bool buildLegendRows(const Plot *plot, PlotCache *cache, const Font *font)
+{
+    freeLegendRows(cache);
+
+    cache->legendRows = malloc((plot->numSeries > 0 ? plot->numSeries : 1) * sizeof(LegendRow));
+    if (!cache->legendRows)
+        return false;
+
+    cache->maxLabelWidth = 0;
+
+    for (int64_t iSeries = 0; iSeries < plot->numSeries; )
+    {
+        LegendRow *row = &cache->legendRows[cache->numLegendRows++];
+        *row = (LegendRow){.firstSeries = iSeries, .numSeries = 1};
+
+        if (plot->legend.grouped)
+            while (iSeries + row->numSeries < plot->numSeries && isSameLegendEntry(&plot->series[iSeries], &plot->series[iSeries + row->numSeries]))
+                row->numSeries++;
+
+        const char *name = plot->series[iSeries].name;
+
+        if (row->numSeries > 1)
+        {
+            const char *label = TextFormat("%s (%lld)", name ? name : "", (long long)row->numSeries);
+            row->label = malloc(strlen(label) + 1);
+            if (row->label)
+                strcpy(row->label, label);
+            name = row->label;
+        }
+
+        row->labelWidth = name ? MeasureTextEx(*font, name, plot->grid.fontSize, 1).x : 0;
+
+        if (row->labelWidth > cache->maxLabelWidth)
+            cache->maxLabelWidth = row->labelWidth;
+
+        iSeries += row->numSeries;
+    }
+
+    return true;
+}
+
+
+// Legend rows are built and measured with the actual legend font, and only rebuilt when series names, styles or the font change
+static const PlotCache *getLegendMetrics(const Plot *plot)
+{
+    PlotCache *cache = getPlotCache(plot);
+    if (!cache)
+        return NULL;
+
+    const Font font = getFont(plot->grid.fontSize, plot->fonts.sdf);
+
+    // Legend rows are requested several times per frame, but series names and styles are only compared once per call
+    if (cache->legendCall == numPlotCalls && cache->legendSeries == plot->series && cache->numLegendEntries == plot->numSeries &&
+        font.glyphs == cache->legendFontGlyphs && plot->grid.fontSize == cache->legendFontSize && plot->legend.grouped == cache->legendGrouped)
+        return cache;
+
+    bool changed = false;
+
+    if (cache->numLegendEntries != plot->numSeries)
+    {
+        LegendEntry *entries = realloc(cache->legendEntries, (plot->numSeries > 0 ? plot->numSeries : 1) * sizeof(LegendEntry));
+        if (!entries)
+            return NULL;
+
+        cache->legendEntries = entries;
+        cache->numLegendEntries = plot->numSeries;
+        changed = true;
+    }
+
+    if (font.glyphs != cache->legendFontGlyphs || plot->grid.fontSize != cache->legendFontSize || plot->legend.grouped != cache->legendGrouped)
+    {
+        cache->legendFontGlyphs = font.glyphs;
+        cache->legendFontSize = plot->grid.fontSize;
+        cache->legendGrouped = plot->legend.grouped;
+        changed = true;
+    }
+
+    for (int iSeries = 0; iSeries < plot->numSeries; iSeries++)
+    {
+        LegendEntry *entry = &cache->legendEntries[iSeries];
+        const Series *series = &plot->series[iSeries];
+
+        if (changed || entry->name != series->name || entry->kind != series->style.kind || entry->color != series->style.color)
+        {
+            *entry = (LegendEntry){series->name, series->style.kind, series->style.color};
+            changed = true;
+        }
+    }
+
+    if (changed && !buildLegendRows(plot, cache, &font))
+    {
+        cache->numLegendEntries = 0;
+        return NULL;
+    }
+
+    cache->legendSeries = plot->series;
+    cache->legendCall = numPlotCalls;
+
+    return cache;
+}
+
+
+static Rectangle getLegendRect(const Plot *plot)
+{
+    const int dashLength = 20, margin = 20;
+    Rectangle legendRect = {0};
+
+    if (!plot->legend.visible)
+        return legendRect;
+
+    const PlotCache *metrics = getLegendMetrics(plot);
+    if (metrics)
+        legendRect.width = metrics->maxLabelWidth;
+    
+    legendRect.width += dashLength + 2 * margin;
+
+    const Rectangle clientRectWithLegend = getClientRectWithLegend();
+
+    if (legendRect.width > clientRectWithLegend.width / 2)
+        legendRect.width = clientRectWithLegend.width / 2;
+
+    legendRect.height = clientRectWithLegend.height;
+    legendRect.x = clientRectWithLegend.x + clientRectWithLegend.width - legendRect.width;
+    legendRect.y = clientRectWithLegend.y;
+
+    return legendRect;
+}
+
+
+static float getLegendRowHeight(const Plot *plot)
+{
+    const int margin = 20;
+    return plot->grid.fontSize + margin;
+}
+
+
+// Rows that intersect the legend rectangle at the current scroll position
+static void getVisibleLegendRows(const Plot *plot, const PlotCache *metrics, const Rectangle *legendRect, int64_t *firstRow, int64_t *lastRow)
+{
+    const float rowHeight = getLegendRowHeight(plot);
+
+    *firstRow = metrics->legendScroll / rowHeight;
+    *lastRow = ceil((metrics->legendScroll + legendRect->height) / rowHeight);
+
+    if (*lastRow > metrics->numLegendRows)
+        *lastRow = metrics->numLegendRows;
+}
+
+
+static Rectangle getLegendRowRect(const Plot *plot, const PlotCache *metrics, const Rectangle *legendRect, int64_t iRow)
+{
+    const float rowHeight = getLegendRowHeight(plot);
+    return (Rectangle){legendRect->x, legendRect->y + iRow * rowHeight - metrics->legendScroll, legendRect->width, rowHeight};
+}
+
+
+static void scrollLegend(const Plot *plot, float delta)
+{
+    const PlotCache *metrics = getLegendMetrics(plot);
+    if (!metrics)
+        return;
+
+    PlotCache *cache = getPlotCache(plot);
+
+    const Rectangle legendRect = getLegendRect(plot);
+    const float maxScroll = metrics->numLegendRows * getLegendRowHeight(plot) - legendRect.height;
+
+    cache->legendScroll += delta;
+
+    if (cache->legendScroll > maxScroll)
+        cache->legendScroll = maxScroll;
+
+    if (cache->legendScroll < 0)
+        cache->legendScroll = 0;
+}
+
+
+static Rectangle getClientRect(const Plot *plot)
+{
+    const Rectangle clientRectWithLegend = getClientRectWithLegend();
+    const Rectangle legendRect = getLegendRect(plot);
+
+    Rectangle clientRect = clientRectWithLegend;
+    clientRect.width -= legendRect.width;
+
+    return clientRect;
+}
+
+
+static Vector2 getScreenPoint(const Point point, const ScreenTransform *transform)
+{
+    return (Vector2){transform->xScale * (point.x - transform->dx), transform->yScale * (point.y - transform->dy)};
+}
+
+
+static Point getGraphPoint(const Vector2 point, const ScreenTransform *transform)
+{
+    return (Point){point.x / transform->xScale + transform->dx, point.y / transform->yScale + transform->dy};
+}
+
+
+static void getIndexCell(const SeriesIndex *index, const Point *pt, int *col, int *row)
+{
+    double x = floor((pt->x - index->gridMinX) / index->cellWidth);
+    double y = floor((pt->y - index->gridMinY) / index->cellHeight);
+
+    // Clamped before the conversion, which is undefined for NaN and out-of-range values
+    x = (x >= 0) ? x : 0;
+    y = (y >= 0) ? y : 0;
+
+    *col = (x < index->cols) ? x : index->cols - 1;
+    *row = (y < index->rows) ? y : index->rows - 1;
+}
+
+
+static bool isFinitePoint(const Point *pt)
+{
+    return isfinite(pt->x) && isfinite(pt->y);
+}
+
+
+static bool buildSeriesIndex(SeriesIndex *index, const Series *series)
+{
+    freeSeriesIndex(index);
+
+    *index = (SeriesIndex){.points = series->points, .numPoints = series->numPoints, .built = true, .sorted = true};
+
+    Point minPt = (Point){ DBL_MAX,  DBL_MAX};
+    Point maxPt = (Point){-DBL_MAX, -DBL_MAX};
+
+    for (int64_t iPt = 0; iPt < series->numPoints; iPt++)
+    {
+        // Series with NaN or infinite points go to the grid, which leaves such points out
+        const Point *pt = &series->points[iPt];
+        if (!isFinitePoint(pt))
+        {
+            index->sorted = false;
+            continue;
+        }
+
+        if (pt->x > maxPt.x)  maxPt.x = pt->x;
+        if (pt->x < minPt.x)  minPt.x = pt->x;
+        if (pt->y > maxPt.y)  maxPt.y = pt->y;
+        if (pt->y < minPt.y)  minPt.y = pt->y;
+
+        if (iPt > 0 && pt->x < series->points[iPt - 1].x)
+            index->sorted = false;
+    }
+
+    index->minY = minPt.y;
+    index->maxY = maxPt.y;
+
+    index->prefixY = malloc((series->numPoints + 1) * sizeof(double));
+    if (!index->prefixY)
+    {
+        index->built = false;
+        return false;
+    }
+
+    index->prefixY[0] = 0;
+
+    if (index->sorted)
+    {
+        for (int64_t iPt = 0; iPt < series->numPoints; iPt++)
+            index->prefixY[iPt + 1] = index->prefixY[iPt] + series->points[iPt].y;
+
+        return true;
+    }
+
+    // About 8 points per cell, at most 1024 x 1024 cells
+
+    int size = sqrt(series->numPoints / 8.0);
+    if (size < 1)     size = 1;
+    if (size > 1024)  size = 1024;
+
+    index->cols = index->rows = size;
+    index->gridMinX = minPt.x;
+    index->gridMinY = minPt.y;
+    index->cellWidth  = (maxPt.x > minPt.x) ? (maxPt.x - minPt.x) / size : 1.0;
+    index->cellHeight = (maxPt.y > minPt.y) ? (maxPt.y - minPt.y) / size : 1.0;
+
+    index->cellStarts = calloc(size * size + 1, sizeof(int64_t));
+    index->cellPoints = malloc((series->numPoints > 0 ? series->numPoints : 1) * sizeof(int64_t));
+    index->cellMinY = malloc(size * size * sizeof(double));
+    index->cellMaxY = malloc(size * size * sizeof(double));
+
+    if (!index->cellStarts || !index->cellPoints || !index->cellMinY || !index->cellMaxY)
+    {
+        index->built = false;
+        return false;
+    }
+
+    // Counting sort of the points by cell
+    for (int64_t iPt = 0; iPt < series->numPoints; iPt++)
+    {
+        if (!isFinitePoint(&series->points[iPt]))
+            continue;
+
+        int col, row;
+        getIndexCell(index, &series->points[iPt], &col, &row);
+        index->cellStarts[row * size + col + 1]++;
+    }
+
+    for (int iCell = 0; iCell < size * size; iCell++)
+        index->cellStarts[iCell + 1] += index->cellStarts[iCell];
+
+    int64_t *cellEnds = malloc(size * size * sizeof(int64_t));
+    if (!cellEnds)
+    {
+        index->built = false;
+        return false;
+    }
+
+    memcpy(cellEnds, index->cellStarts, size * size * sizeof(int64_t));
+
+    for (int64_t iPt = 0; iPt < series->numPoints; iPt++)
+    {
+        if (!isFinitePoint(&series->points[iPt]))
+            continue;
+
+        int col, row;
+        getIndexCell(index, &series->points[iPt], &col, &row);
+        index->cellPoints[cellEnds[row * size + col]++] = iPt;
+    }
+
+    free(cellEnds);
+
+    // Per-cell statistics let whole cells inside a selection skip their points
+    for (int iCell = 0; iCell < size * size; iCell++)
+    {
+        index->cellMinY[iCell] = DBL_MAX;
+        index->cellMaxY[iCell] = -DBL_MAX;
+
+        for (int64_t i = index->cellStarts[iCell]; i < index->cellStarts[iCell + 1]; i++)
+        {
+            const double y = series->points[index->cellPoints[i]].y;
+            index->prefixY[i + 1] = index->prefixY[i] + y;
+
+            if (y < index->cellMinY[iCell])  index->cellMinY[iCell] = y;
+            if (y > index->cellMaxY[iCell])  index->cellMaxY[iCell] = y;
+        }
+    }
+
+    return true;
+}
+
+
+static const SeriesIndex *getSeriesIndex(const Plot *plot, int iSeries)
+{
+    PlotCache *cache = getPlotCache(plot);
+    if (!cache)
+        return NULL;
+
+    if (cache->numSeriesIndices != plot->numSeries)
+    {
+        for (int i = 0; i < cache->numSeriesIndices; i++)
+            freeSeriesIndex(&cache->seriesIndices[i]);
+
+        free(cache->seriesIndices);
+
+        cache->seriesIndices = calloc(plot->numSeries > 0 ? plot->numSeries : 1, sizeof(SeriesIndex));
+        cache->numSeriesIndices = cache->seriesIndices ? plot->numSeries : 0;
+
+        if (!cache->seriesIndices)
+            return NULL;
+    }
+
+    SeriesIndex *index = &cache->seriesIndices[iSeries];
+    const Series *series = &plot->series[iSeries];
+
+    // Rebuilt whenever the data have been replaced or resized
+    if (!index->built || index->points != series->points || index->numPoints != series->numPoints)
+        if (!buildSeriesIndex(index, series))
+            return NULL;
+
+    return index;
+}
+
+
+// Binary search in a series sorted by x
+static int64_t findFirstPoint(const Series *series, double x)
+{
+    int64_t first = 0, last = series->numPoints;
+    while (first < last)
+    {
+        const int64_t middle = first + (last - first) / 2;
+        if (series->points[middle].x < x)
+            first = middle + 1;
+        else
+            last = middle;
+    }
+    return first;
+}
+
+
+static void checkNearestPoint(const Series *series, int64_t iPt, const ScreenTransform *transform, Vector2 pos, float *minDist, int64_t *iNearestPt)
+{
+    const Vector2 pt = getScreenPoint(series->points[iPt], transform);
+    const float dist = (pt.x - pos.x) * (pt.x - pos.x) + (pt.y - pos.y) * (pt.y - pos.y);
+
+    if (dist < *minDist)
+    {
+        *minDist = dist;
+        *iNearestPt = iPt;
+    }
+}
+
+
+// Finds the point closest to the screen position within the given radius, in pixels
+static bool findNearestPoint(const Plot *plot, const ScreenTransform *transform, Vector2 pos, float radius, int64_t *iNearestSeries, int64_t *iNearestPt)
+{
+    float minDist = radius * radius;
+    bool found = false;
+
+    const Point center = getGraphPoint(pos, transform);
+    const double dx = radius / fabs(transform->xScale);
+    const double dy = radius / fabs(transform->yScale);
+
+    for (int iSeries = 0; iSeries < plot->numSeries; iSeries++)
+    {
+        const Series *series = &plot->series[iSeries];
+        if (series->style.kind != STYLE_LINE && series->style.kind != STYLE_SCATTER && series->style.kind != STYLE_DENSITY && 
+            series->style.kind != STYLE_LINE_DENSITY && series->style.kind != STYLE_SPLAT && series->style.kind != STYLE_HISTOGRAM)
+            continue;
+
+        const SeriesIndex *index = getSeriesIndex(plot, iSeries);
+        if (!index)
+            continue;
+
+        int64_t iPt = -1;
+
+        if (index->sorted)
+        {
+            for (int64_t i = findFirstPoint(series, center.x - dx); i < series->numPoints && series->points[i].x <= center.x + dx; i++)
+                checkNearestPoint(series, i, transform, pos, &minDist, &iPt);
+        }
+        else
+        {
+            int minCol, minRow, maxCol, maxRow;
+            getIndexCell(index, &(Point){center.x - dx, center.y - dy}, &minCol, &minRow);
+            getIndexCell(index, &(Point){center.x + dx, center.y + dy}, &maxCol, &maxRow);
+
+            for (int row = minRow; row <= maxRow; row++)
+                for (int col = minCol; col <= maxCol; col++)
+                {
+                    const int iCell = row * index->cols + col;
+                    for (int64_t i = index->cellStarts[iCell]; i < index->cellStarts[iCell + 1]; i++)
+                        checkNearestPoint(series, index->cellPoints[i], transform, pos, &minDist, &iPt);
+                }
+        }
+
+        if (iPt >= 0)
+        {
+            *iNearestSeries = iSeries;
+            *iNearestPt = iPt;
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+
+static SeriesSelection *selection;
+static int64_t numSelectionSeries;
+
+
+static void clearSelection()
+{
+    for (int iSeries = 0; iSeries < numSelectionSeries; iSeries++)
+        free(selection[iSeries].indices);
+
+    free(selection);
+    selection = NULL;
+    numSelectionSeries = 0;
+}
+
+
+static void addToSelection(SeriesSelection *sel, int64_t iPt, double y)
+{
+    sel->indices[sel->numIndices++] = iPt;
+    sel->sum += y;
+    if (y < sel->min)  sel->min = y;
+    if (y > sel->max)  sel->max = y;
+}
+
+
+static void selectSortedPoints(const Series *series, const SeriesIndex *index, const Point *minPt, const Point *maxPt, SeriesSelection *sel)
+{
+    const int64_t first = findFirstPoint(series, minPt->x);
+    const int64_t last = findFirstPoint(series, nextafter(maxPt->x, DBL_MAX));
+
+    sel->indices = malloc((last > first ? last - first : 1) * sizeof(int64_t));
+    if (!sel->indices)
+        return;
+
+    if (minPt->y <= index->minY && maxPt->y >= index->maxY)
+    {
+        // The box spans the whole y range: the selection is a contiguous run with its sum taken from prefix sums
+        for (int64_t iPt = first; iPt < last; iPt++)
+        {
+            const double y = series->points[iPt].y;
+            if (y < sel->min)  sel->min = y;
+            if (y > sel->max)  sel->max = y;
+            sel->indices[iPt - first] = iPt;
+        }
+
+        sel->numIndices = last - first;
+        sel->sum = index->prefixY[last] - index->prefixY[first];
+        return;
+    }
+
+    for (int64_t iPt = first; iPt < last; iPt++)
+    {
+        const double y = series->points[iPt].y;
+        if (y >= minPt->y && y <= maxPt->y)
+            addToSelection(sel, iPt, y);
+    }
+}
+
+
+static void selectGridPoints(const Series *series, const SeriesIndex *index, const Point *minPt, const Point *maxPt, SeriesSelection *sel)
+{
+    int minCol, minRow, maxCol, maxRow;
+    getIndexCell(index, minPt, &minCol, &minRow);
+    getIndexCell(index, maxPt, &maxCol, &maxRow);
+
+    int64_t capacity = 0;
+    for (int row = minRow; row <= maxRow; row++)
+        capacity += index->cellStarts[row * index->cols + maxCol + 1] - index->cellStarts[row * index->cols + minCol];
+
+    sel->indices = malloc((capacity > 0 ? capacity : 1) * sizeof(int64_t));
+    if (!sel->indices)
+        return;
+
+    for (int row = minRow; row <= maxRow; row++)
+        for (int col = minCol; col <= maxCol; col++)
+        {
+            const int iCell = row * index->cols + col;
+            const int64_t first = index->cellStarts[iCell], last = index->cellStarts[iCell + 1];
+
+            if (first == last)
+                continue;
+
+            const double cellMinX = index->gridMinX + col * index->cellWidth;
+            const double cellMinY = index->gridMinY + row * index->cellHeight;
+
+            const bool inside = cellMinX >= minPt->x && cellMinX + index->cellWidth  <= maxPt->x && 
+                                cellMinY >= minPt->y && cellMinY + index->cellHeight <= maxPt->y;
+
+            if (inside)
+            {
+                // Whole cell: copy the indices and use the precomputed statistics
+                memcpy(&sel->indices[sel->numIndices], &index->cellPoints[first], (last - first) * sizeof(int64_t));
+                sel->numIndices += last - first;
+                sel->sum += index->prefixY[last] - index->prefixY[first];
+                if (index->cellMinY[iCell] < sel->min)  sel->min = index->cellMinY[iCell];
+                if (index->cellMaxY[iCell] > sel->max)  sel->max = index->cellMaxY[iCell];
+            }
+            else
+            {
+                for (int64_t i = first; i < last; i++)
+                {
+                    const Point *pt = &series->points[index->cellPoints[i]];
+                    if (pt->x >= minPt->x && pt->x <= maxPt->x && pt->y >= minPt->y && pt->y <= maxPt->y)
+                        addToSelection(sel, index->cellPoints[i], pt->y);
+                }
+            }
+        }
+}
+
+
+// Replaces the selection with the points of all series inside the box, given in graph coordinates
+static void selectPoints(const Plot *plot, const Point *minPt, const Point *maxPt)
+{
+    clearSelection();
+
+    selection = calloc(plot->numSeries > 0 ? plot->numSeries : 1, sizeof(SeriesSelection));
+    if (!selection)
+        return;
+
+    numSelectionSeries = plot->numSeries;
+
+    for (int iSeries = 0; iSeries < plot->numSeries; iSeries++)
+    {
+        const Series *series = &plot->series[iSeries];
+        SeriesSelection *sel = &selection[iSeries];
+
+        sel->min = DBL_MAX;
+        sel->max = -DBL_MAX;
+
+        if (series->style.kind != STYLE_LINE && series->style.kind != STYLE_SCATTER && series->style.kind != STYLE_DENSITY && 
+            series->style.kind != STYLE_LINE_DENSITY && series->style.kind != STYLE_SPLAT && series->style.kind != STYLE_HISTOGRAM)
+            continue;
+
+        const SeriesIndex *index = getSeriesIndex(plot, iSeries);
+        if (!index)
+            continue;
+
+        if (index->sorted)
+            selectSortedPoints(series, index, minPt, maxPt, sel);
+        else
+            selectGridPoints(series, index, minPt, maxPt, sel);
+    }
+}
+
+
+static int64_t getPyramidBlockCount(int64_t numPoints, int iLevel)
+{
+    const int shift = PYRAMID_BASE_LEVEL + iLevel;
+    return (numPoints + ((int64_t)1 << shift) - 1) >> shift;
+}
+
+
+typedef struct
+{
+    const Point *points;
+    int64_t numPoints;
+    const MinMax *children;         // NULL for the finest level, which is computed from the points
+    int64_t numChildren;
+    MinMax *blocks;
+    int64_t firstBlock;
+} PyramidLevelTask;
+
+
+static void buildPyramidBlocks(void *data, int64_t first, int64_t last)
+{
+    const PyramidLevelTask *task = (const PyramidLevelTask *)data;
+
+    for (int64_t iBlock = task->firstBlock + first; iBlock < task->firstBlock + last; iBlock++)
+    {
+        MinMax block = {DBL_MAX, -DBL_MAX};
+
+        if (task->children)
+        {
+            for (int64_t iChild = 2 * iBlock; iChild < 2 * iBlock + 2 && iChild < task->numChildren; iChild++)
+            {
+                if (task->children[iChild].minY < block.minY)  block.minY = task->children[iChild].minY;
+                if (task->children[iChild].maxY > block.maxY)  block.maxY = task->children[iChild].maxY;
+            }
+        }
+        else
+        {
+            const int64_t firstPt = iBlock << PYRAMID_BASE_LEVEL;
+            const int64_t lastPt = (firstPt + (1 << PYRAMID_BASE_LEVEL) < task->numPoints) ? firstPt + (1 << PYRAMID_BASE_LEVEL) : task->numPoints;
+
+            for (int64_t iPt = firstPt; iPt < lastPt; iPt++)
+            {
+                const double y = task->points[iPt].y;
+                if (y < block.minY)  block.minY = y;
+                if (y > block.maxY)  block.maxY = y;
+            }
+        }
+
+        task->blocks[iBlock] = block;
+    }
+}
+
+
+// Recomputes all blocks containing points from firstNewPt on: the whole pyramid for new data, or only its tail for appended data
+static bool extendSeriesPyramid(SeriesPyramid *pyramid, const Series *series, int64_t firstNewPt)
+{
+    for (int64_t iPt = (firstNewPt > 0) ? firstNewPt : 1; iPt < series->numPoints && pyramid->sorted; iPt++)
+        if (series->points[iPt].x < series->points[iPt - 1].x)
+            pyramid->sorted = false;
+
+    pyramid->points = series->points;
+    pyramid->numPoints = series->numPoints;
+    pyramid->built = true;
+
+    if (series->numPoints > 0)
+    {
+        pyramid->firstPt = series->points[0];
+        pyramid->lastPt = series->points[series->numPoints - 1];
+    }
+
+    if (!pyramid->sorted)
+        return true;
+
+    for (int iLevel = 0; iLevel < MAX_PYRAMID_LEVELS; iLevel++)
+    {
+        const int64_t numBlocks = getPyramidBlockCount(series->numPoints, iLevel);
+
+        if (numBlocks > pyramid->levelCapacities[iLevel])
+        {
+            // Appending grows the levels geometrically
+            const int64_t capacity = (firstNewPt > 0 && 2 * pyramid->levelCapacities[iLevel] > numBlocks) ? 2 * pyramid->levelCapacities[iLevel] : numBlocks;
+
+            MinMax *blocks = realloc(pyramid->levels[iLevel], capacity * sizeof(MinMax));
+            if (!blocks)
+            {
+                pyramid->built = false;
+                return false;
+            }
+
+            pyramid->levels[iLevel] = blocks;
+            pyramid->levelCapacities[iLevel] = capacity;
+        }
+
+        if (iLevel >= pyramid->numLevels)
+            pyramid->numLevels = iLevel + 1;
+
+        PyramidLevelTask task = {
+            .points = series->points, 
+            .numPoints = series->numPoints, 
+            .children = (iLevel > 0) ? pyramid->levels[iLevel - 1] : NULL, 
+            .numChildren = (iLevel > 0) ? getPyramidBlockCount(series->numPoints, iLevel - 1) : 0,
+            .blocks = pyramid->levels[iLevel],
+            .firstBlock = firstNewPt >> (PYRAMID_BASE_LEVEL + iLevel)
+        };
+
+        parallelFor(numBlocks - task.firstBlock, 1 << 14, buildPyramidBlocks, &task);
+
+        if (numBlocks <= 1)
+            break;
+    }
+
+    return true;
+}
+
+
+static const SeriesPyramid *getSeriesPyramid(const Plot *plot, int iSeries)
+{
+    PlotCache *cache = getPlotCache(plot);
+    if (!cache)
+        return NULL;
+
+    if (cache->numSeriesPyramids != plot->numSeries)
+    {
+        for (int i = 0; i < cache->numSeriesPyramids; i++)
+            freeSeriesPyramid(&cache->seriesPyramids[i]);
+
+        free(cache->seriesPyramids);
+
+        cache->seriesPyramids = calloc(plot->numSeries > 0 ? plot->numSeries : 1, sizeof(SeriesPyramid));
+        cache->numSeriesPyramids = cache->seriesPyramids ? plot->numSeries : 0;
+
+        if (!cache->seriesPyramids)
+            return NULL;
+    }
+
+    SeriesPyramid *pyramid = &cache->seriesPyramids[iSeries];
+    const Series *series = &plot->series[iSeries];
+
+    if (pyramid->built && pyramid->points == series->points && pyramid->numPoints == series->numPoints)
+        return pyramid;
+
+    // Appended data keep the old points, possibly in a reallocated array
+    const bool appended = pyramid->built && pyramid->numPoints > 0 && series->numPoints > pyramid->numPoints &&
+                          memcmp(&series->points[0], &pyramid->firstPt, sizeof(Point)) == 0 &&
+                          memcmp(&series->points[pyramid->numPoints - 1], &pyramid->lastPt, sizeof(Point)) == 0;
+
+    int64_t firstNewPt = 0;
+
+    if (appended)
+        firstNewPt = pyramid->numPoints;
+    else
+    {
+        freeSeriesPyramid(pyramid);
+        pyramid->sorted = true;
+    }
+
+    if (!extendSeriesPyramid(pyramid, series, firstNewPt))
+        return NULL;
+
+    return pyramid;
+}
+
+
+static void addPointRange(const Point *points, int64_t first, int64_t last, MinMax *range)
+{
+    for (int64_t iPt = first; iPt < last; iPt++)
+    {
+        if (points[iPt].y < range->minY)  range->minY = points[iPt].y;
+        if (points[iPt].y > range->maxY)  range->maxY = points[iPt].y;
+    }
+}
+
+
+static void addBlock(const MinMax *block, MinMax *range)
+{
+    if (block->minY < range->minY)  range->minY = block->minY;
+    if (block->maxY > range->maxY)  range->maxY = block->maxY;
+}
+
+
+// Returns the y range of points [first, last) from O(log n) pyramid blocks and at most two partial base blocks
+static MinMax getPyramidRange(const SeriesPyramid *pyramid, int64_t first, int64_t last)
+{
+    MinMax range = {DBL_MAX, -DBL_MAX};
+    const int64_t blockSize = 1 << PYRAMID_BASE_LEVEL;
+
+    // Unaligned ends are scanned directly; the partial last block of the series counts as aligned
+    int64_t alignedFirst = (first + blockSize - 1) & ~(blockSize - 1);
+    int64_t alignedLast = (last == pyramid->numPoints) ? last : last & ~(blockSize - 1);
+
+    if (alignedFirst >= alignedLast)
+    {
+        addPointRange(pyramid->points, first, last, &range);
+        return range;
+    }
+
+    addPointRange(pyramid->points, first, alignedFirst, &range);
+    addPointRange(pyramid->points, alignedLast, last, &range);
+
+    // Bottom-up segment tree traversal
+    int64_t firstBlock = alignedFirst >> PYRAMID_BASE_LEVEL;
+    int64_t lastBlock = (alignedLast + blockSize - 1) >> PYRAMID_BASE_LEVEL;
+
+    for (int iLevel = 0; iLevel < pyramid->numLevels && firstBlock < lastBlock; iLevel++)
+    {
+        if (firstBlock & 1)
+            addBlock(&pyramid->levels[iLevel][firstBlock++], &range);
+
+        if (lastBlock & 1)
+            addBlock(&pyramid->levels[iLevel][--lastBlock], &range);
+
+        firstBlock >>= 1;
+        lastBlock >>= 1;
+    }
+
+    return range;
+}
+
+
+static void setTransformToMinMax(const Plot *plot, ScreenTransform *transform, const Point *minPt, const Point *maxPt)
+{
+    Rectangle rect = getClientRect(plot);
+
+    transform->xScale = (maxPt->x > minPt->x) ?  (rect.width  / (maxPt->x - minPt->x)) : 1.0;
+    transform->yScale = (maxPt->y > minPt->y) ? -(rect.height / (maxPt->y - minPt->y)) : 1.0; 
+
+    transform->dx = minPt->x - rect.x / transform->xScale;
+    transform->dy = maxPt->y - rect.y / transform->yScale;
+}
+
+
+// The last bin of a histogram series is as wide as the previous one
+static double getHistogramBinRight(const Series *series, int64_t iPt)
+{
+    if (iPt + 1 < series->numPoints)
+        return series->points[iPt + 1].x;
+
+    if (series->numPoints > 1)
+        return 2 * series->points[iPt].x - series->points[iPt - 1].x;
+
+    return series->points[iPt].x + 1;
+}
+
+
+static void resetTransform(const Plot *plot, ScreenTransform *transform)
+{
+    Point minPt = (Point){ DBL_MAX,  DBL_MAX};
+    Point maxPt = (Point){-DBL_MAX, -DBL_MAX};
+
+    for (int iSeries = 0; iSeries < plot->numSeries; iSeries++)
+    {
+        Series *series = &plot->series[iSeries];
+        for (int iPt = 0; iPt < series->numPoints; iPt++)
+        {
+            const Point *pt = &series->points[iPt];
+            if (pt->x > maxPt.x)  maxPt.x = pt->x;
+            if (pt->x < minPt.x)  minPt.x = pt->x;
+            if (pt->y > maxPt.y)  maxPt.y = pt->y;
+            if (pt->y < minPt.y)  minPt.y = pt->y;
+        }
+
+        // Bars stand on zero and the last one extends past its point
+        if (series->style.kind == STYLE_HISTOGRAM && series->numPoints > 0)
+        {
+            const double right = getHistogramBinRight(series, series->numPoints - 1);
+
+            if (right > maxPt.x)  maxPt.x = right;
+            if (0 > maxPt.y)      maxPt.y = 0;
+            if (0 < minPt.y)      minPt.y = 0;
+        }
+    }
+
+    setTransformToMinMax(plot, transform, &minPt, &maxPt);
+}
+
+
+static void resizeTransform(const Plot *plot, ScreenTransform *transform, const Rectangle *rect)
+{
+    const Point minPt = getGraphPoint((Vector2){rect->x, rect->y + rect->height}, transform);
+    const Point maxPt = getGraphPoint((Vector2){rect->x + rect->width, rect->y}, transform);
+
+    setTransformToMinMax(plot, transform, &minPt, &maxPt);
+}
+
+
+static void panTransform(const Plot *plot, ScreenTransform *transform, const Vector2 *delta)
+{
+    transform->dx -= delta->x / transform->xScale;
+    transform->dy -= delta->y / transform->yScale;
+}
+
+
+static void zoomTransform(const Plot *plot, ScreenTransform *transform, const Rectangle *zoomRect)
+{
+    if (zoomRect->width == 0 && zoomRect->height == 0)
+        return;
+
+    if (zoomRect->width < 0 || zoomRect->height < 0)
+    {
+        resetTransform(plot, transform);
+        return;
+    }
+
+    resizeTransform(plot, transform, zoomRect);
+}
+
+
+// Zooms by the given factor, keeping the graph point under the cursor in place
+static void wheelZoomTransform(const Plot *plot, ScreenTransform *transform, const Vector2 *pos, double factor)
+{
+    const Rectangle rect = getClientRect(plot);
+
+    const Point center = getGraphPoint(*pos, transform);
+    Point minPt = getGraphPoint((Vector2){rect.x, rect.y + rect.height}, transform);
+    Point maxPt = getGraphPoint((Vector2){rect.x + rect.width, rect.y}, transform);
+
+    minPt = (Point){center.x + (minPt.x - center.x) / factor, center.y + (minPt.y - center.y) / factor};
+    maxPt = (Point){center.x + (maxPt.x - center.x) / factor, center.y + (maxPt.y - center.y) / factor};
+
+    setTransformToMinMax(plot, transform, &minPt, &maxPt);
+}
+
+
+static void getAnimationRange(const Animation *anim, int64_t numPts, int64_t *firstPt, int64_t *lastPt)
+{
+    *firstPt = 0;
+    *lastPt = numPts;
+
+    if (!anim || anim->numFrames <= 0)
+        return;
+
+    // Growing prefix, optionally clipped to a sliding window
+    *lastPt = (numPts * (anim->frame + 1) + anim->numFrames - 1) / anim->numFrames;
+    if (*lastPt > numPts)
+        *lastPt = numPts;
+
+    if (anim->window > 0 && *lastPt - anim->window > 0)
+        *firstPt = *lastPt - anim->window;
+}
+
+
+enum
+{
+    PREVIEW_MAX_POINTS = 20000,     // Per series, while the view is being zoomed or panned
+    PREVIEW_IDLE_FRAMES = 5         // Frames without input before the full resolution is drawn again
+};
+
+
+// Draws the points [firstPt, lastPt) of a line series as one vertical y range per pixel column, joined by the lines between 
+// the columns. Returns false if the visible points are too sparse for that
+static bool drawLodLine(const Series *series, const SeriesPyramid *pyramid, const ScreenTransform *transform, const Rectangle *clientRect, int64_t firstPt, int64_t lastPt)
+{
+    const Color color = *(Color *)&series->style.color;
+    const float width = series->style.width;
+
+    const double minX = getGraphPoint((Vector2){clientRect->x, 0}, transform).x;
+    const double maxX = getGraphPoint((Vector2){clientRect->x + clientRect->width, 0}, transform).x;
+
+    int64_t first = findFirstPoint(series, minX);
+    int64_t last = findFirstPoint(series, nextafter(maxX, DBL_MAX));
+
+    if (first < firstPt)  first = firstPt;
+    if (last > lastPt)    last = lastPt;
+
+    if (last - first < LOD_MIN_POINTS_PER_PIXEL * clientRect->width)
+        return false;
+
+    // Lines to the nearest points outside the client rectangle are clipped by the scissor
+    Vector2 prevPt = {0};
+    bool hasPrevPt = false;
+
+    if (first > firstPt)
+    {
+        prevPt = getScreenPoint(series->points[first - 1], transform);
+        hasPrevPt = true;
+    }
+
+    const int numColumns = ceil(clientRect->width);
+    int64_t columnFirst = first;
+
+    for (int column = 0; column < numColumns && columnFirst < last; column++)
+    {
+        int64_t columnLast = last;
+        if (column < numColumns - 1)
+        {
+            columnLast = findFirstPoint(series, getGraphPoint((Vector2){clientRect->x + column + 1, 0}, transform).x);
+            if (columnLast > last)
+                columnLast = last;
+        }
+
+        if (columnLast <= columnFirst)
+            continue;
+
+        const Vector2 firstScreenPt = getScreenPoint(series->points[columnFirst], transform);
+        if (hasPrevPt)
+            DrawLineEx(prevPt, firstScreenPt, width, color);
+
+        const MinMax range = getPyramidRange(pyramid, columnFirst, columnLast);
+        const float x = clientRect->x + column + 0.5;
+
+        DrawLineEx((Vector2){x, getScreenPoint((Point){0, range.maxY}, transform).y}, (Vector2){x, getScreenPoint((Point){0, range.minY}, transform).y}, width, color);
+
+        prevPt = getScreenPoint(series->points[columnLast - 1], transform);
+        hasPrevPt = true;
+        columnFirst = columnLast;
+    }
+
+    if (hasPrevPt && last < lastPt)
+        DrawLineEx(prevPt, getScreenPoint(series->points[last], transform), width, color);
+
+    return true;
+}
+
+
+// Draws every step-th point of [firstPt, lastPt) without level-of-detail reduction
+static void drawSeriesPoints(const Series *series, const ScreenTransform *transform, int64_t firstPt, int64_t lastPt, int64_t step)
+{
+    switch (series->style.kind)
+    {
+        case STYLE_LINE:
+        case STYLE_LINE_DENSITY:
+        {
+            if (lastPt - firstPt > 1)
+            {
+                Vector2 prevPt = getScreenPoint(series->points[firstPt], transform);                
+                
+                for (int64_t iPt = firstPt + step; iPt < lastPt + step - 1; iPt += step)
+                {
+                    // The last point is always reached
+                    Vector2 pt = getScreenPoint(series->points[iPt < lastPt ? iPt : lastPt - 1], transform); 
+                    DrawLineEx(prevPt, pt, series->style.width, *(Color *)&series->style.color);
+                    prevPt = pt;
+                }
+            }                
+            break;
+        }
+
+        case STYLE_SCATTER:
+        case STYLE_SPLAT:
+        {
+            for (int64_t iPt = firstPt; iPt < lastPt; iPt += step)
+            {
+                Vector2 pt = getScreenPoint(series->points[iPt], transform); 
+                DrawCircleV(pt, series->style.width, *(Color *)&series->style.color);
+            }
+            break;
+        }
+
+        default: break;
+    }
+}
+
+
+// Keeps valid set only if the raster was rendered for exactly this view and data, otherwise makes room for rendering it
+static bool prepareSeriesRaster(SeriesRaster *raster, const ScreenTransform *transform, const Rectangle *rect, const Point *points, int64_t firstPt, int64_t lastPt)
+{
+    raster->valid = raster->valid && raster->pixels && memcmp(&raster->transform, transform, sizeof(ScreenTransform)) == 0 && 
+                    memcmp(&raster->rect, rect, sizeof(Rectangle)) == 0 && raster->points == points && 
+                    raster->firstPt == firstPt && raster->lastPt == lastPt;
+
+    if (raster->valid)
+        return true;
+
+    if (!raster->pixels || raster->rect.width != rect->width || raster->rect.height != rect->height)
+    {
+        free(raster->pixels);
+        raster->pixels = malloc((rect->width * rect->height > 0 ? rect->width * rect->height : 1) * sizeof(Color));
+        if (!raster->pixels)
+            return false;
+    }
+
+    raster->transform = *transform;
+    raster->rect = *rect;
+    raster->points = points;
+    raster->firstPt = firstPt;
+    raster->lastPt = lastPt;
+
+    return true;
+}
+
+
+enum
+{
+    OCCUPANCY_MIN_POINTS = 4096,        // Sparser scatter series are drawn directly
+    OCCUPANCY_MAX_RADIUS = 16,
+    CIRCLE_SEGMENTS = 36                // Used by DrawCircleV()
+};
+
+
+// Opaque scatter series with enough points to be drawn with an occupancy bitmap
+static bool hasDistinctMarkers(const Series *series, int64_t numPts)
+{
+    const Color color = *(Color *)&series->style.color;
+    return series->style.kind == STYLE_SCATTER && color.a == 255 && series->style.width <= OCCUPANCY_MAX_RADIUS && numPts >= OCCUPANCY_MIN_POINTS;
+}
+
+
+// One bit per pixel of the scissor rectangle, pixels outside it are never painted
+static uint8_t *createOccupancy(const Rectangle *clientRect)
+{
+    return calloc((int64_t)((int)clientRect->width) * ((int)clientRect->height) / 8 + 1, 1);
+}
+
+
+// Draws every step-th point of [firstPt, lastPt) of a series with distinct markers, skipping the markers that would only 
+// cover pixels already painted by the previous markers of the series, as recorded in the occupancy bitmap. The output is 
+// the same as from drawSeriesPoints()
+static void drawDistinctMarkers(const Series *series, const ScreenTransform *transform, const Rectangle *clientRect, int64_t firstPt, int64_t lastPt, int64_t step, uint8_t *painted)
+{
+    const Color color = *(Color *)&series->style.color;
+    const float radius = series->style.width;
+
+    const int left = clientRect->x, top = clientRect->y, width = clientRect->width, height = clientRect->height;
+
+    // Pixels with the centers inside the polygon inscribed in the marker circle are surely painted, those farther than 
+    // the radius surely not
+    const float inner = radius * cosf(PI / CIRCLE_SEGMENTS) - 0.01f;
+    const float outer = radius + 0.01f;
+
+    for (int64_t iPt = firstPt; iPt < lastPt; iPt += step)
+    {
+        const Vector2 pt = getScreenPoint(series->points[iPt], transform);
+
+        if (!(pt.x + outer >= left && pt.x - outer <= left + width && pt.y + outer >= top && pt.y - outer <= top + height))
+            continue;
+
+        const int firstCol = fmaxf(ceilf(pt.x - outer - 0.5f), left), lastCol = fminf(floorf(pt.x + outer - 0.5f), left + width - 1);
+        const int firstRow = fmaxf(ceilf(pt.y - outer - 0.5f), top),  lastRow = fminf(floorf(pt.y + outer - 0.5f), top + height - 1);
+
+        bool covered = true;
+
+        for (int row = firstRow; row <= lastRow && covered; row++)
+            for (int col = firstCol; col <= lastCol && covered; col++)
+            {
+                const float dx = col + 0.5f - pt.x, dy = row + 0.5f - pt.y;
+                const int64_t iPixel = (int64_t)(row - top) * width + (col - left);
+
+                if (dx * dx + dy * dy <= outer * outer && !(painted[iPixel / 8] & (1 << (iPixel % 8))))
+                    covered = false;
+            }
+
+        if (covered)
+            continue;
+
+        DrawCircleV(pt, radius, color);
+
+        for (int row = firstRow; row <= lastRow; row++)
+            for (int col = firstCol; col <= lastCol; col++)
+            {
+                const float dx = col + 0.5f - pt.x, dy = row + 0.5f - pt.y;
+                const int64_t iPixel = (int64_t)(row - top) * width + (col - left);
+
+                if (dx * dx + dy * dy < inner * inner)
+                    painted[iPixel / 8] |= 1 << (iPixel % 8);
+            }
+    }
+}
+
+
+// Returns the raster of the series for the view, with valid set only if it was rendered for exactly this view and data
+static SeriesRaster *getSeriesRaster(const Plot *plot, int iSeries, const ScreenTransform *transform, const Rectangle *rect, int64_t firstPt, int64_t lastPt)
+{
+    PlotCache *cache = getPlotCache(plot);
+    if (!cache)
+        return NULL;
+
+    if (cache->numSeriesRasters != plot->numSeries)
+    {
+        for (int i = 0; i < cache->numSeriesRasters; i++)
+            freeSeriesRaster(&cache->seriesRasters[i]);
+
+        free(cache->seriesRasters);
+
+        cache->seriesRasters = calloc(plot->numSeries > 0 ? plot->numSeries : 1, sizeof(SeriesRaster));
+        cache->numSeriesRasters = cache->seriesRasters ? plot->numSeries : 0;
+
+        if (!cache->seriesRasters)
+            return NULL;
+    }
+
+    SeriesRaster *raster = &cache->seriesRasters[iSeries];
+    return prepareSeriesRaster(raster, transform, rect, plot->series[iSeries].points, firstPt, lastPt) ? raster : NULL;
+}
+
+
+// Uploads the rendered pixels, reusing the texture of the current context if the size has not changed
+static void uploadSeriesRaster(SeriesRaster *raster)
+{
+    const int width = raster->rect.width, height = raster->rect.height;
+    const bool loaded = raster->texture.id != 0 && raster->context == numClosedContexts;
+
+    if (loaded && raster->texture.width == width && raster->texture.height == height)
+        UpdateTexture(raster->texture, raster->pixels);
+    else
+    {
+        if (loaded)
+            UnloadTexture(raster->texture);
+
+        const Image image = {raster->pixels, width, height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+        raster->texture = LoadTextureFromImage(image);
+        raster->context = numClosedContexts;
+    }
+
+    raster->valid = true;
+}
+
+
+enum
+{
+    COLORMAP_SIZE = 256
+};
+
+
+// Perceptually uniform colormap (viridis), from low to high values, interpolated between 10 anchors. Precomputed, 
+// since it is read by parallel tasks
+static const Color viridisColormap[COLORMAP_SIZE] = {
+    {68, 1, 84, 255}, {68, 2, 85, 255}, {68, 3, 86, 255}, {68, 5, 87, 255}, {68, 6, 89, 255}, {68, 7, 90, 255},
+    {68, 9, 91, 255}, {68, 10, 92, 255}, {69, 12, 94, 255}, {69, 13, 95, 255}, {69, 14, 96, 255}, {69, 16, 97, 255},
+    {69, 17, 99, 255}, {69, 18, 100, 255}, {69, 20, 101, 255}, {70, 21, 103, 255}, {70, 23, 104, 255}, {70, 24, 105, 255},
+    {70, 25, 106, 255}, {70, 27, 108, 255}, {70, 28, 109, 255}, {70, 29, 110, 255}, {71, 31, 111, 255}, {71, 32, 113, 255},
+    {71, 34, 114, 255}, {71, 35, 115, 255}, {71, 36, 117, 255}, {71, 38, 118, 255}, {71, 39, 119, 255}, {71, 40, 120, 255},
+    {71, 42, 121, 255}, {71, 43, 121, 255}, {70, 44, 122, 255}, {70, 45, 122, 255}, {70, 46, 123, 255}, {69, 48, 124, 255},
+    {69, 49, 124, 255}, {68, 50, 125, 255}, {68, 51, 125, 255}, {68, 52, 126, 255}, {67, 54, 127, 255}, {67, 55, 127, 255},
+    {67, 56, 128, 255}, {66, 57, 128, 255}, {66, 58, 129, 255}, {66, 60, 130, 255}, {65, 61, 130, 255}, {65, 62, 131, 255},
+    {65, 63, 131, 255}, {64, 64, 132, 255}, {64, 66, 133, 255}, {64, 67, 133, 255}, {63, 68, 134, 255}, {63, 69, 134, 255},
+    {62, 70, 135, 255}, {62, 72, 136, 255}, {62, 73, 136, 255}, {61, 74, 137, 255}, {61, 75, 137, 255}, {60, 76, 137, 255},
+    {60, 77, 137, 255}, {60, 78, 137, 255}, {59, 79, 137, 255}, {59, 80, 138, 255}, {58, 81, 138, 255}, {58, 82, 138, 255},
+    {57, 83, 138, 255}, {57, 84, 138, 255}, {56, 86, 139, 255}, {56, 87, 139, 255}, {55, 88, 139, 255}, {55, 89, 139, 255},
+    {54, 90, 139, 255}, {54, 91, 139, 255}, {54, 92, 140, 255}, {53, 93, 140, 255}, {53, 94, 140, 255}, {52, 95, 140, 255},
+    {52, 96, 140, 255}, {51, 97, 140, 255}, {51, 98, 141, 255}, {50, 99, 141, 255}, {50, 100, 141, 255}, {49, 101, 141, 255},
+    {49, 102, 141, 255}, {49, 104, 142, 255}, {48, 104, 142, 255}, {48, 105, 142, 255}, {47, 106, 142, 255}, {47, 107, 142, 255},
+    {47, 108, 142, 255}, {46, 109, 142, 255}, {46, 110, 142, 255}, {45, 111, 142, 255}, {45, 112, 142, 255}, {45, 113, 142, 255},
+    {44, 114, 142, 255}, {44, 115, 142, 255}, {43, 115, 142, 255}, {43, 116, 142, 255}, {43, 117, 142, 255}, {42, 118, 142, 255},
+    {42, 119, 142, 255}, {42, 120, 142, 255}, {41, 121, 142, 255}, {41, 122, 142, 255}, {40, 123, 142, 255}, {40, 124, 142, 255},
+    {40, 125, 142, 255}, {39, 126, 142, 255}, {39, 126, 142, 255}, {38, 127, 142, 255}, {38, 128, 142, 255}, {38, 129, 142, 255},
+    {37, 130, 141, 255}, {37, 131, 141, 255}, {37, 132, 141, 255}, {37, 133, 141, 255}, {36, 134, 141, 255}, {36, 135, 141, 255},
+    {36, 136, 140, 255}, {36, 137, 140, 255}, {35, 138, 140, 255}, {35, 139, 140, 255}, {35, 140, 140, 255}, {35, 141, 139, 255},
+    {34, 142, 139, 255}, {34, 143, 139, 255}, {34, 144, 139, 255}, {34, 145, 139, 255}, {33, 146, 139, 255}, {33, 147, 138, 255},
+    {33, 148, 138, 255}, {33, 149, 138, 255}, {32, 150, 138, 255}, {32, 151, 138, 255}, {32, 152, 138, 255}, {32, 153, 137, 255},
+    {31, 154, 137, 255}, {31, 155, 137, 255}, {31, 156, 137, 255}, {31, 157, 137, 255}, {31, 158, 136, 255}, {32, 159, 136, 255},
+    {32, 160, 135, 255}, {33, 160, 135, 255}, {34, 161, 134, 255}, {35, 162, 133, 255}, {35, 163, 133, 255}, {36, 164, 132, 255},
+    {37, 165, 132, 255}, {38, 166, 131, 255}, {39, 167, 131, 255}, {39, 168, 130, 255}, {40, 168, 130, 255}, {41, 169, 129, 255},
+    {42, 170, 128, 255}, {42, 171, 128, 255}, {43, 172, 127, 255}, {44, 173, 127, 255}, {45, 174, 126, 255}, {46, 175, 126, 255},
+    {46, 175, 125, 255}, {47, 176, 124, 255}, {48, 177, 124, 255}, {49, 178, 123, 255}, {49, 179, 123, 255}, {50, 180, 122, 255},
+    {51, 181, 122, 255}, {52, 182, 121, 255}, {53, 183, 121, 255}, {54, 183, 119, 255}, {56, 184, 118, 255}, {58, 185, 117, 255},
+    {60, 186, 116, 255}, {62, 186, 115, 255}, {64, 187, 114, 255}, {66, 188, 113, 255}, {68, 189, 111, 255}, {70, 189, 110, 255},
+    {72, 190, 109, 255}, {74, 191, 108, 255}, {76, 192, 107, 255}, {78, 193, 106, 255}, {80, 193, 105, 255}, {82, 194, 104, 255},
+    {84, 195, 102, 255}, {86, 196, 101, 255}, {88, 196, 100, 255}, {90, 197, 99, 255}, {92, 198, 98, 255}, {94, 199, 97, 255},
+    {96, 200, 96, 255}, {98, 200, 95, 255}, {100, 201, 93, 255}, {102, 202, 92, 255}, {104, 203, 91, 255}, {106, 203, 90, 255},
+    {108, 204, 89, 255}, {110, 205, 87, 255}, {113, 206, 86, 255}, {115, 206, 84, 255}, {118, 207, 83, 255}, {120, 207, 81, 255},
+    {123, 208, 79, 255}, {125, 209, 78, 255}, {128, 209, 76, 255}, {130, 210, 75, 255}, {133, 210, 73, 255}, {135, 211, 72, 255},
+    {138, 212, 70, 255}, {140, 212, 68, 255}, {143, 213, 67, 255}, {145, 213, 65, 255}, {148, 214, 64, 255}, {150, 215, 62, 255},
+    {153, 215, 60, 255}, {155, 216, 59, 255}, {158, 216, 57, 255}, {160, 217, 56, 255}, {163, 218, 54, 255}, {165, 218, 52, 255},
+    {168, 219, 51, 255}, {170, 219, 49, 255}, {173, 220, 48, 255}, {175, 221, 46, 255}, {178, 221, 45, 255}, {180, 222, 43, 255},
+    {183, 222, 43, 255}, {186, 222, 43, 255}, {188, 223, 43, 255}, {191, 223, 42, 255}, {193, 223, 42, 255}, {196, 224, 42, 255},
+    {198, 224, 42, 255}, {201, 224, 41, 255}, {204, 224, 41, 255}, {206, 225, 41, 255}, {209, 225, 41, 255}, {211, 225, 40, 255},
+    {214, 226, 40, 255}, {216, 226, 40, 255}, {219, 226, 40, 255}, {222, 227, 39, 255}, {224, 227, 39, 255}, {227, 227, 39, 255},
+    {229, 228, 39, 255}, {232, 228, 38, 255}, {234, 228, 38, 255}, {237, 229, 38, 255}, {240, 229, 38, 255}, {242, 229, 37, 255},
+    {245, 230, 37, 255}, {247, 230, 37, 255}, {250, 230, 37, 255}, {253, 231, 37, 255}
+};
+
+
+static const Color *getColormap()
+{
+    return viridisColormap;
+}
+
+
+// Per-pixel counts for a CPU-rendered image: each task accumulates into its own grid, then the grids are summed up
+typedef struct
+{
+    const Series *series;
+    int64_t firstPt, lastPt;
+    ScreenTransform transform;
+    Rectangle rect;
+    int width, height;
+
+    int numTasks;
+    uint32_t *grids;            // numTasks grids of width * height counts
+    uint32_t maxCount;
+    Color *pixels;
+} CountTask;
+
+
+static void binPoints(void *data, int64_t first, int64_t last)
+{
+    const CountTask *task = (const CountTask *)data;
+    const int64_t numPts = task->lastPt - task->firstPt;
+
+    for (int64_t iTask = first; iTask < last; iTask++)
+    {
+        uint32_t *grid = &task->grids[iTask * task->width * task->height];
+
+        const int64_t firstPt = task->firstPt + numPts * iTask / task->numTasks;
+        const int64_t lastPt = task->firstPt + numPts * (iTask + 1) / task->numTasks;
+
+        for (int64_t iPt = firstPt; iPt < lastPt; iPt++)
+        {
+            const Vector2 pt = getScreenPoint(task->series->points[iPt], &task->transform);
+            const float x = pt.x - task->rect.x, y = pt.y - task->rect.y;
+
+            if (x >= 0 && x < task->width && y >= 0 && y < task->height)
+                grid[(int)y * task->width + (int)x]++;
+        }
+    }
+}
+
+
+static void sumGrids(void *data, int64_t first, int64_t last)
+{
+    const CountTask *task = (const CountTask *)data;
+    const int64_t gridSize = task->width * task->height;
+
+    for (int64_t iTask = 1; iTask < task->numTasks; iTask++)
+    {
+        const uint32_t *grid = &task->grids[iTask * gridSize];
+        for (int64_t i = first; i < last; i++)
+            task->grids[i] += grid[i];
+    }
+}
+
+
+static void colorizeCounts(void *data, int64_t first, int64_t last)
+{
+    const CountTask *task = (const CountTask *)data;
+    const Color *colormap = getColormap();
+    const float scale = (task->maxCount > 0) ? (COLORMAP_SIZE - 1) / logf(1.0f + task->maxCount) : 0;
+
+    // Logarithmic scale, empty pixels stay transparent
+    for (int64_t i = first; i < last; i++)
+    {
+        const uint32_t count = task->grids[i];
+        task->pixels[i] = (count > 0) ? colormap[(int)(logf(1.0f + count) * scale)] : BLANK;
+    }
+}
+
+
+// Maps the per-pixel counts in the first grid to colors
+static void colorizeGrid(CountTask *task)
+{
+    const int64_t gridSize = task->width * task->height;
+
+    task->maxCount = 0;
+    for (int64_t i = 0; i < gridSize; i++)
+        if (task->grids[i] > task->maxCount)
+            task->maxCount = task->grids[i];
+
+    parallelFor(gridSize, 1 << 16, colorizeCounts, task);
+}
+
+
+// Renders the colormapped 2D histogram of the points with a bin per pixel of rect
+static bool renderDensity(const Series *series, const ScreenTransform *transform, const Rectangle *rect, int64_t firstPt, int64_t lastPt, Color *pixels)
+{
+    CountTask task = {
+        .series = series, 
+        .firstPt = firstPt, 
+        .lastPt = lastPt, 
+        .transform = *transform, 
+        .rect = *rect, 
+        .width = rect->width, 
+        .height = rect->height,
+        .pixels = pixels
+    };
+
+    // A partial grid per thread avoids atomic increments
+    task.numTasks = getNumThreads();
+    if (task.numTasks > (lastPt - firstPt) / 65536 + 1)
+        task.numTasks = (lastPt - firstPt) / 65536 + 1;
+
+    task.grids = calloc((int64_t)task.numTasks * task.width * task.height, sizeof(uint32_t));
+    if (!task.grids)
+        return false;
+
+    parallelFor(task.numTasks, 1, binPoints, &task);
+    parallelFor((int64_t)task.width * task.height, 1 << 16, sumGrids, &task);
+    colorizeGrid(&task);
+
+    free(task.grids);
+    return true;
+}
+
+
+// Scatter series with the density style are drawn as a colormapped 2D histogram with a bin per pixel. The histogram is 
+// only recomputed when the view or the data change
+static bool drawDensity(const Plot *plot, int iSeries, const ScreenTransform *transform, const Rectangle *clientRect, int64_t firstPt, int64_t lastPt)
+{
+    const Rectangle rect = {floorf(clientRect->x), floorf(clientRect->y), ceilf(clientRect->width), ceilf(clientRect->height)};
+
+    SeriesRaster *raster = getSeriesRaster(plot, iSeries, transform, &rect, firstPt, lastPt);
+    if (!raster)
+        return false;
+
+    if (!raster->valid)
+    {
+        if (!renderDensity(&plot->series[iSeries], transform, &rect, firstPt, lastPt, raster->pixels))
+            return false;
+
+        uploadSeriesRaster(raster);
+    }
+
+    DrawTexture(raster->texture, rect.x, rect.y, WHITE);
+    return true;
+}
+
+
+// Coverage of the series with the line density style: each task rasterizes its share of the series into its own grid
+enum
+{
+    LINE_DENSITY_MAX_GRID_BYTES = 1 << 27   // Bounds the count and stamp grids of all tasks together
+};
+
+
+typedef struct
+{
+    CountTask counts;
+    const PointSpan *spans;
+    int64_t numSpans;
+    uint32_t *stamps;           // numTasks grids holding 1 + the last span that covered each pixel
+} LineDensityTask;
+
+
+// Clips the segment to the rectangle [0, width] x [0, height] (Liang-Barsky)
+static bool clipSegment(double *x0, double *y0, double *x1, double *y1, double width, double height)
+{
+    const double dx = *x1 - *x0, dy = *y1 - *y0;
+    const double p[4] = {-dx, dx, -dy, dy};
+    const double q[4] = {*x0, width - *x0, *y0, height - *y0};
+
+    double t0 = 0, t1 = 1;
+
+    for (int i = 0; i < 4; i++)
+    {
+        if (p[i] == 0)
+        {
+            if (q[i] < 0)
+                return false;
+            continue;
+        }
+
+        const double t = q[i] / p[i];
+
+        if (p[i] < 0)
+        {
+            if (t > t1)  return false;
+            if (t > t0)  t0 = t;
+        }
+        else
+        {
+            if (t < t0)  return false;
+            if (t < t1)  t1 = t;
+        }
+    }
+
+    const double startX = *x0, startY = *y0;
+
+    *x0 = startX + t0 * dx;
+    *y0 = startY + t0 * dy;
+    *x1 = startX + t1 * dx;
+    *y1 = startY + t1 * dy;
+
+    return true;
+}
+
+
+static void rasterizeSegment(const LineDensityTask *task, uint32_t *grid, uint32_t *stamps, uint32_t stamp, double x0, double y0, double x1, double y1)
+{
+    const int width = task->counts.width, height = task->counts.height;
+
+    if (!clipSegment(&x0, &y0, &x1, &y1, width, height))
+        return;
+
+    // A pixel is counted once per series, however many of its segments cross it
+    const int numSteps = ceil(fmax(fabs(x1 - x0), fabs(y1 - y0)));
+
+    for (int i = 0; i <= numSteps; i++)
+    {
+        const double t = (numSteps > 0) ? (double)i / numSteps : 0;
+        const int x = x0 + t * (x1 - x0), y = y0 + t * (y1 - y0);
+
+        if (x < 0 || x >= width || y < 0 || y >= height)
+            continue;
+
+        const int64_t iPixel = (int64_t)y * width + x;
+        if (stamps[iPixel] != stamp)
+        {
+            stamps[iPixel] = stamp;
+            grid[iPixel]++;
+        }
+    }
+}
+
+
+static void binLines(void *data, int64_t first, int64_t last)
+{
+    const LineDensityTask *task = (const LineDensityTask *)data;
+    const int64_t gridSize = (int64_t)task->counts.width * task->counts.height;
+    const ScreenTransform *transform = &task->counts.transform;
+
+    for (int64_t iTask = first; iTask < last; iTask++)
+    {
+        uint32_t *grid = &task->counts.grids[iTask * gridSize];
+        uint32_t *stamps = &task->stamps[iTask * gridSize];
+
+        const int64_t firstSpan = task->numSpans * iTask / task->counts.numTasks;
+        const int64_t lastSpan = task->numSpans * (iTask + 1) / task->counts.numTasks;
+
+        for (int64_t iSpan = firstSpan; iSpan < lastSpan; iSpan++)
+        {
+            const PointSpan *span = &task->spans[iSpan];
+            const uint32_t stamp = iSpan + 1;
+
+            double prevX = 0, prevY = 0;
+            bool hasPrevPt = false;
+
+            for (int64_t iPt = span->firstPt; iPt < span->lastPt; iPt++)
+            {
+                const double x = transform->xScale * (span->points[iPt].x - transform->dx) - task->counts.rect.x;
+                const double y = transform->yScale * (span->points[iPt].y - transform->dy) - task->counts.rect.y;
+
+                if (!isfinite(x) || !isfinite(y))
+                {
+                    hasPrevPt = false;
+                    continue;
+                }
+
+                if (hasPrevPt)
+                    rasterizeSegment(task, grid, stamps, stamp, prevX, prevY, x, y);
+                else if (iPt + 1 == span->lastPt)
+                    rasterizeSegment(task, grid, stamps, stamp, x, y, x, y);
+
+                prevX = x;
+                prevY = y;
+                hasPrevPt = true;
+            }
+        }
+    }
+}
+
+
+// Collects the point ranges of the series with the line density style
+static PointSpan *getLineDensitySpans(const Plot *plot, const Animation *anim, int64_t *numSpans)
+{
+    PointSpan *spans = malloc((plot->numSeries > 0 ? plot->numSeries : 1) * sizeof(PointSpan));
+    if (!spans)
+        return NULL;
+
+    *numSpans = 0;
+
+    for (int iSeries = 0; iSeries < plot->numSeries; iSeries++)
+    {
+        const Series *series = &plot->series[iSeries];
+        if (series->style.kind != STYLE_LINE_DENSITY)
+            continue;
+
+        PointSpan *span = &spans[(*numSpans)++];
+        span->points = series->points;
+        getAnimationRange(anim, series->numPoints, &span->firstPt, &span->lastPt);
+    }
+
+    return spans;
+}
+
+
+// Renders the colormapped count of the spans crossing each pixel of rect
+static bool renderLineDensity(const PointSpan *spans, int64_t numSpans, const ScreenTransform *transform, const Rectangle *rect, Color *pixels)
+{
+    LineDensityTask task = {
+        .counts = {
+            .transform = *transform, 
+            .rect = *rect, 
+            .width = rect->width, 
+            .height = rect->height,
+            .pixels = pixels
+        },
+        .spans = spans,
+        .numSpans = numSpans
+    };
+
+    // Each task needs a count and a stamp grid of the whole image, so large images are binned by fewer tasks
+    const int64_t taskBytes = (int64_t)task.counts.width * task.counts.height * 2 * sizeof(uint32_t);
+    const int64_t maxTasks = (taskBytes > 0) ? LINE_DENSITY_MAX_GRID_BYTES / taskBytes : 1;
+
+    task.counts.numTasks = getNumThreads();
+    if (task.counts.numTasks > maxTasks)
+        task.counts.numTasks = maxTasks > 0 ? maxTasks : 1;
+    if (task.counts.numTasks > numSpans)
+        task.counts.numTasks = numSpans > 0 ? numSpans : 1;
+
+    const int64_t gridsSize = (int64_t)task.counts.numTasks * task.counts.width * task.counts.height;
+
+    task.counts.grids = calloc(gridsSize, sizeof(uint32_t));
+    task.stamps = calloc(gridsSize, sizeof(uint32_t));
+
+    if (!task.counts.grids || !task.stamps)
+    {
+        free(task.counts.grids);
+        free(task.stamps);
+        return false;
+    }
+
+    parallelFor(task.counts.numTasks, 1, binLines, &task);
+    parallelFor((int64_t)task.counts.width * task.counts.height, 1 << 16, sumGrids, &task.counts);
+    colorizeGrid(&task.counts);
+
+    free(task.counts.grids);
+    free(task.stamps);
+    return true;
+}
+
+
+// All series with the line density style are drawn together, in place of the first of them, as a colormapped count of the 
+// series crossing each pixel. The cost per pixel does not depend on the number of series, and the counts are only recomputed 
+// when the view or the data change
+static bool drawLineDensity(const Plot *plot, const ScreenTransform *transform, const Rectangle *clientRect, const Animation *anim)
+{
+    PlotCache *cache = getPlotCache(plot);
+    if (!cache)
+        return false;
+
+    const Rectangle rect = {floorf(clientRect->x), floorf(clientRect->y), ceilf(clientRect->width), ceilf(clientRect->height)};
+
+    int64_t numSpans = 0;
+    PointSpan *spans = getLineDensitySpans(plot, anim, &numSpans);
+    if (!spans)
+        return false;
+
+    SeriesRaster *raster = &cache->lineDensityRaster;
+
+    if (numSpans != cache->numLineDensitySpans || memcmp(spans, cache->lineDensitySpans, numSpans * sizeof(PointSpan)) != 0)
+        raster->valid = false;
+
+    free(cache->lineDensitySpans);
+    cache->lineDensitySpans = spans;
+    cache->numLineDensitySpans = numSpans;
+
+    if (!prepareSeriesRaster(raster, transform, &rect, NULL, 0, 0))
+        return false;
+
+    if (!raster->valid)
+    {
+        if (!renderLineDensity(spans, numSpans, transform, &rect, raster->pixels))
+            return false;
+
+        uploadSeriesRaster(raster);
+    }
+
+    DrawTexture(raster->texture, rect.x, rect.y, WHITE);
+    return true;
+}
+
+
+enum
+{
+    SPLAT_BATCH_POINTS = 1 << 22,       // Points bucketed at a time, bounds the memory for the buckets
+    SPLAT_BANDS_PER_THREAD = 4
+};
+
+
+// Markers splatted on the CPU: the image is split into horizontal bands, the points are bucketed by the bands their markers 
+// overlap, then each band is drawn by a single task, so no pixel is written concurrently
+typedef struct
+{
+    const Series *series;
+    ScreenTransform transform;
+    Rectangle rect;
+    int width, height;
+    float radius;
+
+    int64_t batchFirst, batchLast;
+    int numChunks, numBands, bandHeight;
+    int64_t *chunkOffsets;          // numChunks * numBands counts, then write positions into entries
+    int64_t *bandStarts;            // numBands + 1 offsets into entries
+    int64_t *entries;               // Point indices bucketed by band
+
+    float *transparency;            // Product of (1 - alpha * coverage) over the markers covering each pixel
+    Color *pixels;
+} SplatTask;
+
+
+static bool getSplatBands(const SplatTask *task, int64_t iPt, Vector2 *pos, int *firstBand, int *lastBand)
+{
+    const ScreenTransform *transform = &task->transform;
+    const Point *pt = &task->series->points[iPt];
+
+    pos->x = transform->xScale * (pt->x - transform->dx) - task->rect.x;
+    pos->y = transform->yScale * (pt->y - transform->dy) - task->rect.y;
+
+    const float extent = task->radius + 1;
+
+    if (!(pos->x > -extent && pos->x < task->width + extent && pos->y > -extent && pos->y < task->height + extent))
+        return false;
+
+    *firstBand = (pos->y - extent > 0) ? (int)(pos->y - extent) / task->bandHeight : 0;
+    *lastBand = (pos->y + extent > 0) ? (int)(pos->y + extent) / task->bandHeight : 0;
+
+    if (*lastBand >= task->numBands)
+        *lastBand = task->numBands - 1;
+
+    return true;
+}
+
+
+static void countSplats(void *data, int64_t first, int64_t last)
+{
+    const SplatTask *task = (const SplatTask *)data;
+    const int64_t numPts = task->batchLast - task->batchFirst;
+
+    for (int64_t iChunk = first; iChunk < last; iChunk++)
+    {
+        int64_t *counts = &task->chunkOffsets[iChunk * task->numBands];
+
+        const int64_t firstPt = task->batchFirst + numPts * iChunk / task->numChunks;
+        const int64_t lastPt = task->batchFirst + numPts * (iChunk + 1) / task->numChunks;
+
+        for (int64_t iPt = firstPt; iPt < lastPt; iPt++)
+        {
+            Vector2 pos;
+            int firstBand, lastBand;
+
+            if (getSplatBands(task, iPt, &pos, &firstBand, &lastBand))
+                for (int iBand = firstBand; iBand <= lastBand; iBand++)
+                    counts[iBand]++;
+        }
+    }
+}
+
+
+static void bucketSplats(void *data, int64_t first, int64_t last)
+{
+    const SplatTask *task = (const SplatTask *)data;
+    const int64_t numPts = task->batchLast - task->batchFirst;
+
+    for (int64_t iChunk = first; iChunk < last; iChunk++)
+    {
+        int64_t *offsets = &task->chunkOffsets[iChunk * task->numBands];
+
+        const int64_t firstPt = task->batchFirst + numPts * iChunk / task->numChunks;
+        const int64_t lastPt = task->batchFirst + numPts * (iChunk + 1) / task->numChunks;
+
+        for (int64_t iPt = firstPt; iPt < lastPt; iPt++)
+        {
+            Vector2 pos;
+            int firstBand, lastBand;
+
+            if (getSplatBands(task, iPt, &pos, &firstBand, &lastBand))
+                for (int iBand = firstBand; iBand <= lastBand; iBand++)
+                    task->entries[offsets[iBand]++] = iPt;
+        }
+    }
+}
+
+
+static void drawSplats(void *data, int64_t first, int64_t last)
+{
+    const SplatTask *task = (const SplatTask *)data;
+    const float alpha = ((Color *)&task->series->style.color)->a / 255.0f;
+    const float radius = task->radius;
+
+    for (int64_t iBand = first; iBand < last; iBand++)
+    {
+        const int bandFirstRow = iBand * task->bandHeight;
+        const int bandLastRow = (bandFirstRow + task->bandHeight < task->height) ? bandFirstRow + task->bandHeight : task->height;
+
+        for (int64_t iEntry = task->bandStarts[iBand]; iEntry < task->bandStarts[iBand + 1]; iEntry++)
+        {
+            Vector2 pos;
+            int firstBand, lastBand;
+            getSplatBands(task, task->entries[iEntry], &pos, &firstBand, &lastBand);
+
+            int firstRow = floorf(pos.y - radius - 0.5f), lastRow = ceilf(pos.y + radius + 0.5f);
+            int firstCol = floorf(pos.x - radius - 0.5f), lastCol = ceilf(pos.x + radius + 0.5f);
+
+            if (firstRow < bandFirstRow)  firstRow = bandFirstRow;
+            if (lastRow > bandLastRow)    lastRow = bandLastRow;
+            if (firstCol < 0)             firstCol = 0;
+            if (lastCol > task->width)    lastCol = task->width;
+
+            // Disc with an antialiased edge one pixel wide
+            for (int row = firstRow; row < lastRow; row++)
+            {
+                const float dy = row + 0.5f - pos.y;
+
+                for (int col = firstCol; col < lastCol; col++)
+                {
+                    const float dx = col + 0.5f - pos.x;
+                    float coverage = radius + 0.5f - sqrtf(dx * dx + dy * dy);
+
+                    if (coverage <= 0)
+                        continue;
+                    if (coverage > 1)
+                        coverage = 1;
+
+                    task->transparency[(int64_t)row * task->width + col] *= 1 - alpha * coverage;
+                }
+            }
+        }
+    }
+}
+
+
+static void colorizeSplats(void *data, int64_t first, int64_t last)
+{
+    const SplatTask *task = (const SplatTask *)data;
+    const Color color = *(Color *)&task->series->style.color;
+
+    // All markers have the same color, so blending them in any order leaves only the accumulated opacity to be found
+    for (int64_t i = first; i < last; i++)
+        task->pixels[i] = (Color){color.r, color.g, color.b, (1 - task->transparency[i]) * 255 + 0.5f};
+}
+
+
+static bool splatPoints(SplatTask *task, int64_t firstPt, int64_t lastPt)
+{
+    const int numThreads = getNumThreads();
+
+    task->numChunks = numThreads;
+    task->numBands = numThreads * SPLAT_BANDS_PER_THREAD;
+    if (task->numBands > task->height)
+        task->numBands = task->height > 0 ? task->height : 1;
+
+    task->bandHeight = (task->height + task->numBands - 1) / task->numBands;
+    if (task->bandHeight < 1)
+        task->bandHeight = 1;
+
+    const int64_t gridSize = (int64_t)task->width * task->height;
+
+    task->transparency = malloc((gridSize > 0 ? gridSize : 1) * sizeof(float));
+    task->chunkOffsets = malloc(task->numChunks * task->numBands * sizeof(int64_t));
+    task->bandStarts = malloc((task->numBands + 1) * sizeof(int64_t));
+    task->entries = NULL;
+
+    bool ok = task->transparency && task->chunkOffsets && task->bandStarts;
+
+    for (int64_t i = 0; ok && i < gridSize; i++)
+        task->transparency[i] = 1;
+
+    int64_t entriesCapacity = 0;
+
+    for (task->batchFirst = firstPt; ok && task->batchFirst < lastPt; task->batchFirst = task->batchLast)
+    {
+        task->batchLast = (lastPt - task->batchFirst > SPLAT_BATCH_POINTS) ? task->batchFirst + SPLAT_BATCH_POINTS : lastPt;
+
+        memset(task->chunkOffsets, 0, task->numChunks * task->numBands * sizeof(int64_t));
+        parallelFor(task->numChunks, 1, countSplats, task);
+
+        // Entries are laid out band by band, and within a band chunk by chunk
+        int64_t numEntries = 0;
+        for (int iBand = 0; iBand < task->numBands; iBand++)
+        {
+            task->bandStarts[iBand] = numEntries;
+            for (int iChunk = 0; iChunk < task->numChunks; iChunk++)
+            {
+                int64_t *offset = &task->chunkOffsets[iChunk * task->numBands + iBand];
+                const int64_t count = *offset;
+                *offset = numEntries;
+                numEntries += count;
+            }
+        }
+        task->bandStarts[task->numBands] = numEntries;
+
+        if (numEntries > entriesCapacity)
+        {
+            free(task->entries);
+            task->entries = malloc(numEntries * sizeof(int64_t));
+            entriesCapacity = task->entries ? numEntries : 0;
+
+            if (!task->entries)
+            {
+                ok = false;
+                break;
+            }
+        }
+
+        parallelFor(task->numChunks, 1, bucketSplats, task);
+        parallelFor(task->numBands, 1, drawSplats, task);
+    }
+
+    if (ok)
+        parallelFor(gridSize, 1 << 16, colorizeSplats, task);
+
+    free(task->transparency);
+    free(task->chunkOffsets);
+    free(task->bandStarts);
+    free(task->entries);
+
+    return ok;
+}
+
+
+// Renders the markers of the points into the pixels of rect
+static bool renderSplats(const Series *series, const ScreenTransform *transform, const Rectangle *rect, int64_t firstPt, int64_t lastPt, Color *pixels)
+{
+    SplatTask task = {
+        .series = series,
+        .transform = *transform,
+        .rect = *rect,
+        .width = rect->width,
+        .height = rect->height,
+        .radius = series->style.width,
+        .pixels = pixels
+    };
+
+    return splatPoints(&task, firstPt, lastPt);
+}
+
+
+// Scatter series with the splat style are drawn into a CPU image by all cores and shown as a single texture, which avoids 
+// submitting every marker to the GPU. The image is only redrawn when the view or the data change
+static bool drawSplatSeries(const Plot *plot, int iSeries, const ScreenTransform *transform, const Rectangle *clientRect, int64_t firstPt, int64_t lastPt)
+{
+    const Rectangle rect = {floorf(clientRect->x), floorf(clientRect->y), ceilf(clientRect->width), ceilf(clientRect->height)};
+
+    SeriesRaster *raster = getSeriesRaster(plot, iSeries, transform, &rect, firstPt, lastPt);
+    if (!raster)
+        return false;
+
+    if (!raster->valid)
+    {
+        if (!renderSplats(&plot->series[iSeries], transform, &rect, firstPt, lastPt, raster->pixels))
+            return false;
+
+        uploadSeriesRaster(raster);
+    }
+
+    DrawTexture(raster->texture, rect.x, rect.y, WHITE);
+    return true;
+}
+
+
+// Histogram series hold a point per bin: the left edge and the count. The bars are drawn as rectangles, which raylib 
+// batches into a single draw call, and the bars narrower than a pixel are merged into a bar per pixel column
+static bool drawHistogram(const Series *series, const ScreenTransform *transform, const Rectangle *clientRect, int64_t firstPt, int64_t lastPt)
+{
+    const Color color = *(Color *)&series->style.color;
+    const float baseY = getScreenPoint((Point){0, 0}, transform).y;
+
+    int pendingColumn = INT_MIN;
+    float pendingY = baseY;
+
+    for (int64_t iPt = firstPt; iPt <= lastPt; iPt++)
+    {
+        float left = 0, right = 0, y = baseY;
+
+        if (iPt < lastPt)
+        {
+            const Vector2 pt = getScreenPoint(series->points[iPt], transform);
+
+            left = pt.x;
+            right = getScreenPoint((Point){getHistogramBinRight(series, iPt), 0}, transform).x;
+            y = pt.y;
+
+            if (right < clientRect->x || left > clientRect->x + clientRect->width || !(right > left))
+                continue;
+        }
+
+        // The pending column is drawn when the next bar does not start in it
+        const bool narrow = iPt < lastPt && right - left < 1;
+        
+        if (pendingColumn != INT_MIN && (!narrow || (int)floorf(left) != pendingColumn))
+        {
+            DrawRectangleRec((Rectangle){pendingColumn, fminf(pendingY, baseY), 1, fabsf(pendingY - baseY)}, color);
+            pendingColumn = INT_MIN;
+        }
+
+        if (iPt == lastPt)
+            break;
+
+        if (narrow)
+        {
+            if (pendingColumn == INT_MIN)
+            {
+                pendingColumn = floorf(left);
+                pendingY = y;
+            }
+            else if (fabsf(y - baseY) > fabsf(pendingY - baseY))
+                pendingY = y;
+        }
+        else
+        {
+            // Wide bars are separated by a gap
+            const float gap = (right - left >= 4) ? 1 : 0;
+            DrawRectangleRec((Rectangle){left, fminf(y, baseY), right - left - gap, fabsf(y - baseY)}, color);
+        }
+    }
+
+    return true;
+}
+
+
+enum
+{
+    IMAGE_TILE_SIZE = 4096          // Texture size supported by any OpenGL 3.3 hardware in practice
+};
+
+
+// Range of the values mapped to the colormap
+static void getImageRange(const ImageData *image, double *minValue, double *maxValue)
+{
+    *minValue = image->minValue;
+    *maxValue = image->maxValue;
+
+    if (*minValue < *maxValue)
+        return;
+
+    *minValue = DBL_MAX;
+    *maxValue = -DBL_MAX;
+
+    const int64_t numValues = image->numRows * image->numCols;
+
+    for (int64_t i = 0; i < numValues; i++)
+        if (isfinite(image->values[i]))
+        {
+            if (image->values[i] < *minValue)  *minValue = image->values[i];
+            if (image->values[i] > *maxValue)  *maxValue = image->values[i];
+        }
+
+    if (*minValue > *maxValue)
+        *minValue = *maxValue = 0;
+}
+
+
+static Color getImageColor(double value, double minValue, double scale)
+{
+    if (value != value)
+        return BLANK;
+
+    const double index = (value - minValue) * scale;
+    return getColormap()[(index <= 0) ? 0 : (index >= COLORMAP_SIZE - 1) ? COLORMAP_SIZE - 1 : (int)index];
+}
+
+
+// Colors of a tile of an image series
+typedef struct
+{
+    const ImageData *image;
+    double minValue, scale;
+    int64_t firstRow, firstCol;
+    int width, height;
+    Color *pixels;
+} ImageTileTask;
+
+
+static void colorizeImageRows(void *data, int64_t first, int64_t last)
+{
+    const ImageTileTask *task = (const ImageTileTask *)data;
+    const Color *colormap = getColormap();
+
+    for (int64_t row = first; row < last; row++)
+    {
+        const double *values = &task->image->values[(task->firstRow + row) * task->image->numCols + task->firstCol];
+        Color *pixels = &task->pixels[row * task->width];
+
+        // Branch-free apart from NaNs, so that the loop vectorizes
+        for (int col = 0; col < task->width; col++)
+        {
+            double index = (values[col] - task->minValue) * task->scale;
+            index = (index > 0) ? index : 0;
+            index = (index < COLORMAP_SIZE - 1) ? index : COLORMAP_SIZE - 1;
+
+            pixels[col] = colormap[(int)index];
+        }
+
+        for (int col = 0; col < task->width; col++)
+            if (values[col] != values[col])
+                pixels[col] = BLANK;
+    }
+}
+
+
+// Returns the tiles of an image series, converting and uploading them only if the data have changed. Changing the view 
+// only changes the texture coordinates
+static const SeriesImage *getSeriesImage(const Plot *plot, int iSeries)
+{
+    PlotCache *cache = getPlotCache(plot);
+    if (!cache)
+        return NULL;
+
+    if (cache->numSeriesImages != plot->numSeries)
+    {
+        for (int i = 0; i < cache->numSeriesImages; i++)
+            freeSeriesImage(&cache->seriesImages[i]);
+
+        free(cache->seriesImages);
+
+        cache->seriesImages = calloc(plot->numSeries > 0 ? plot->numSeries : 1, sizeof(SeriesImage));
+        cache->numSeriesImages = cache->seriesImages ? plot->numSeries : 0;
+
+        if (!cache->seriesImages)
+            return NULL;
+    }
+
+    const ImageData *image = &plot->series[iSeries].image;
+    SeriesImage *seriesImage = &cache->seriesImages[iSeries];
+
+    if (seriesImage->tiles && seriesImage->context == numClosedContexts && seriesImage->values == image->values && 
+        seriesImage->numRows == image->numRows && seriesImage->numCols == image->numCols && 
+        seriesImage->minValue == image->minValue && seriesImage->maxValue == image->maxValue)
+        return seriesImage;
+
+    freeSeriesImage(seriesImage);
+
+    ImageTileTask task = {.image = image};
+
+    double maxValue;
+    getImageRange(image, &task.minValue, &maxValue);
+    task.scale = (maxValue > task.minValue) ? COLORMAP_SIZE / (maxValue - task.minValue) : 0;
+
+    const int numTileRows = (image->numRows + IMAGE_TILE_SIZE - 1) / IMAGE_TILE_SIZE;
+    const int numTileCols = (image->numCols + IMAGE_TILE_SIZE - 1) / IMAGE_TILE_SIZE;
+
+    const int64_t maxTileRows = (image->numRows < IMAGE_TILE_SIZE) ? image->numRows : IMAGE_TILE_SIZE;
+    const int64_t maxTileCols = (image->numCols < IMAGE_TILE_SIZE) ? image->numCols : IMAGE_TILE_SIZE;
+
+    seriesImage->tiles = calloc(numTileRows * numTileCols, sizeof(Texture2D));
+    task.pixels = malloc(maxTileRows * maxTileCols * sizeof(Color));
+
+    if (!seriesImage->tiles || !task.pixels)
+    {
+        free(seriesImage->tiles);
+        free(task.pixels);
+        seriesImage->tiles = NULL;
+        return NULL;
+    }
+
+    seriesImage->numTileRows = numTileRows;
+    seriesImage->numTileCols = numTileCols;
+    seriesImage->context = numClosedContexts;
+
+    for (int tileRow = 0; tileRow < numTileRows; tileRow++)
+        for (int tileCol = 0; tileCol < numTileCols; tileCol++)
+        {
+            task.firstRow = (int64_t)tileRow * IMAGE_TILE_SIZE;
+            task.firstCol = (int64_t)tileCol * IMAGE_TILE_SIZE;
+            task.height = (image->numRows - task.firstRow < IMAGE_TILE_SIZE) ? image->numRows - task.firstRow : IMAGE_TILE_SIZE;
+            task.width = (image->numCols - task.firstCol < IMAGE_TILE_SIZE) ? image->numCols - task.firstCol : IMAGE_TILE_SIZE;
+
+            parallelFor(task.height, 64, colorizeImageRows, &task);
+
+            // Mipmaps average the cells when zoomed out, magnified cells stay sharp
+            Texture2D *tile = &seriesImage->tiles[tileRow * numTileCols + tileCol];
+            *tile = LoadTextureFromImage((Image){task.pixels, task.width, task.height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8});
+
+            GenTextureMipmaps(tile);
+            SetTextureWrap(*tile, TEXTURE_WRAP_CLAMP);
+            rlTextureParameters(tile->id, RL_TEXTURE_MIN_FILTER, RL_TEXTURE_FILTER_MIP_LINEAR);
+            rlTextureParameters(tile->id, RL_TEXTURE_MAG_FILTER, RL_TEXTURE_FILTER_NEAREST);
+        }
+
+    seriesImage->values = image->values;
+    seriesImage->numRows = image->numRows;
+    seriesImage->numCols = image->numCols;
+    seriesImage->minValue = image->minValue;
+    seriesImage->maxValue = image->maxValue;
+
+    free(task.pixels);
+    return seriesImage;
+}
+
+
+// Image series are stretched over the rectangle between their first two points. Only the visible part of each tile is drawn
+static bool drawImageSeries(const Plot *plot, int iSeries, const ScreenTransform *transform, const Rectangle *clientRect)
+{
+    const Series *series = &plot->series[iSeries];
+    const ImageData *image = &series->image;
+
+    if (series->numPoints < 2 || !image->values || image->numRows <= 0 || image->numCols <= 0)
+        return true;
+
+    const double minX = fmin(series->points[0].x, series->points[1].x), maxX = fmax(series->points[0].x, series->points[1].x);
+    const double minY = fmin(series->points[0].y, series->points[1].y), maxY = fmax(series->points[0].y, series->points[1].y);
+
+    const double cellWidth = (maxX - minX) / image->numCols, cellHeight = (maxY - minY) / image->numRows;
+    if (!(cellWidth > 0 && cellHeight > 0))
+        return true;
+
+    const SeriesImage *seriesImage = getSeriesImage(plot, iSeries);
+    if (!seriesImage)
+        return false;
+
+    const Point clientPt1 = getGraphPoint((Vector2){clientRect->x, clientRect->y}, transform);
+    const Point clientPt2 = getGraphPoint((Vector2){clientRect->x + clientRect->width, clientRect->y + clientRect->height}, transform);
+
+    const double visibleMinX = fmin(clientPt1.x, clientPt2.x), visibleMaxX = fmax(clientPt1.x, clientPt2.x);
+    const double visibleMinY = fmin(clientPt1.y, clientPt2.y), visibleMaxY = fmax(clientPt1.y, clientPt2.y);
+
+    for (int tileRow = 0; tileRow < seriesImage->numTileRows; tileRow++)
+        for (int tileCol = 0; tileCol < seriesImage->numTileCols; tileCol++)
+        {
+            const Texture2D *tile = &seriesImage->tiles[tileRow * seriesImage->numTileCols + tileCol];
+
+            // Row 0 is on top
+            const double tileMinX = minX + (double)tileCol * IMAGE_TILE_SIZE * cellWidth;
+            const double tileMaxY = maxY - (double)tileRow * IMAGE_TILE_SIZE * cellHeight;
+            const double tileMaxX = tileMinX + tile->width * cellWidth;
+            const double tileMinY = tileMaxY - tile->height * cellHeight;
+
+            const double left = fmax(tileMinX, visibleMinX), right = fmin(tileMaxX, visibleMaxX);
+            const double bottom = fmax(tileMinY, visibleMinY), top = fmin(tileMaxY, visibleMaxY);
+
+            if (left >= right || bottom >= top)
+                continue;
+
+            const Rectangle source = {
+                (left - tileMinX) / cellWidth, 
+                (tileMaxY - top) / cellHeight, 
+                (right - left) / cellWidth, 
+                (top - bottom) / cellHeight
+            };
+
+            const Vector2 destPt1 = getScreenPoint((Point){left, top}, transform);
+            const Vector2 destPt2 = getScreenPoint((Point){right, bottom}, transform);
+            const Rectangle dest = {fminf(destPt1.x, destPt2.x), fminf(destPt1.y, destPt2.y), fabsf(destPt2.x - destPt1.x), fabsf(destPt2.y - destPt1.y)};
+
+            DrawTexturePro(*tile, source, dest, (Vector2){0, 0}, 0, WHITE);
+        }
+
+    return true;
+}
+
+
+// Dense sorted line series are drawn in O(pixels * log n) from the level-of-detail pyramid
+static bool drawLodSeries(const Plot *plot, int iSeries, const ScreenTransform *transform, const Rectangle *clientRect, int64_t firstPt, int64_t lastPt)
+{
+    const Series *series = &plot->series[iSeries];
+
+    if (series->style.kind != STYLE_LINE || lastPt - firstPt <= LOD_MIN_POINTS_PER_PIXEL * clientRect->width)
+        return false;
+
+    const SeriesPyramid *pyramid = getSeriesPyramid(plot, iSeries);
+    return pyramid && pyramid->sorted && drawLodLine(series, pyramid, transform, clientRect, firstPt, lastPt);
+}
+
+
+// Series that are drawn in a single reduced pass rather than point by point
+static bool drawReducedSeries(const Plot *plot, int iSeries, const ScreenTransform *transform, const Rectangle *clientRect, const Animation *anim, int64_t firstPt, int64_t lastPt)
+{
+    if (plot->series[iSeries].style.kind == STYLE_DENSITY)
+        return drawDensity(plot, iSeries, transform, clientRect, firstPt, lastPt);
+
+    if (plot->series[iSeries].style.kind == STYLE_SPLAT)
+        return drawSplatSeries(plot, iSeries, transform, clientRect, firstPt, lastPt);
+
+    if (plot->series[iSeries].style.kind == STYLE_HISTOGRAM)
+        return drawHistogram(&plot->series[iSeries], transform, clientRect, firstPt, lastPt);
+
+    if (plot->series[iSeries].style.kind == STYLE_IMAGE)
+        return drawImageSeries(plot, iSeries, transform, clientRect);
+
+    if (plot->series[iSeries].style.kind == STYLE_LINE_DENSITY)
+    {
+        for (int i = 0; i < iSeries; i++)
+            if (plot->series[i].style.kind == STYLE_LINE_DENSITY)
+                return plot->cache && plot->cache->lineDensityRaster.valid;
+
+        return drawLineDensity(plot, transform, clientRect, anim);
+    }
+
+    return drawLodSeries(plot, iSeries, transform, clientRect, firstPt, lastPt);
+}
+
+
+static void drawGraph(const Plot *plot, const ScreenTransform *transform, const Animation *anim, bool preview)
+{
+    Rectangle clientRect = getClientRect(plot);
+    BeginScissorMode(clientRect.x, clientRect.y, clientRect.width, clientRect.height);
+
+    for (int iSeries = 0; iSeries < plot->numSeries; iSeries++)
+    {
+        const Series *series = &plot->series[iSeries];
+
+        int64_t firstPt, lastPt;
+        getAnimationRange(anim, series->numPoints, &firstPt, &lastPt);
+
+        if (drawReducedSeries(plot, iSeries, transform, &clientRect, anim, firstPt, lastPt))
+            continue;
+
+        // A coarse preview takes every step-th point
+        int64_t step = 1;
+        if (preview && lastPt - firstPt > PREVIEW_MAX_POINTS)
+            step = (lastPt - firstPt + PREVIEW_MAX_POINTS - 1) / PREVIEW_MAX_POINTS;
+
+        uint8_t *painted = hasDistinctMarkers(series, (lastPt - firstPt) / step) ? createOccupancy(&clientRect) : NULL;
+
+        if (painted)
+            drawDistinctMarkers(series, transform, &clientRect, firstPt, lastPt, step, painted);
+        else
+            drawSeriesPoints(series, transform, firstPt, lastPt, step);
+
+        free(painted);
+    }
+
+    EndScissorMode();    
+}
+
+
+enum
+{
+    PROGRESSIVE_CHUNK_POINTS = 16384
+};
+
+
+// Position reached by a graph drawn across several frames
+typedef struct
+{
+    int64_t nextSeries, nextPt;
+    uint8_t *occupancy;         // Kept across the chunks of a series with distinct markers
+} GraphProgress;
+
+
+static void resetGraphProgress(GraphProgress *progress)
+{
+    free(progress->occupancy);
+    *progress = (GraphProgress){0};
+}
+
+
+// Continues drawing the graph in chunks until it is complete or the time budget, in milliseconds, is exhausted.
+// The target keeps the chunks drawn in the previous frames. Returns true when the graph is complete
+static bool drawGraphProgressive(const Plot *plot, const ScreenTransform *transform, GraphProgress *progress, double budget)
+{
+    const double startTime = GetTime();
+
+    Rectangle clientRect = getClientRect(plot);
+    BeginScissorMode(clientRect.x, clientRect.y, clientRect.width, clientRect.height);
+
+    while (progress->nextSeries < plot->numSeries)
+    {
+        const Series *series = &plot->series[progress->nextSeries];
+
+        if (progress->nextPt == 0 && drawReducedSeries(plot, progress->nextSeries, transform, &clientRect, NULL, 0, series->numPoints))
+        {
+            progress->nextSeries++;
+        }
+        else
+        {
+            const int64_t chunkLast = (progress->nextPt + PROGRESSIVE_CHUNK_POINTS < series->numPoints) ? progress->nextPt + PROGRESSIVE_CHUNK_POINTS : series->numPoints;
+
+            // Line chunks start at the last point of the previous chunk
+            const int64_t chunkFirst = ((series->style.kind == STYLE_LINE || series->style.kind == STYLE_LINE_DENSITY) && progress->nextPt > 0) ? progress->nextPt - 1 : progress->nextPt;
+
+            if (progress->nextPt == 0 && hasDistinctMarkers(series, series->numPoints))
+                progress->occupancy = createOccupancy(&clientRect);
+
+            if (progress->occupancy)
+                drawDistinctMarkers(series, transform, &clientRect, chunkFirst, chunkLast, 1, progress->occupancy);
+            else
+                drawSeriesPoints(series, transform, chunkFirst, chunkLast, 1);
+
+            if (chunkLast >= series->numPoints)
+            {
+                progress->nextSeries++;
+                progress->nextPt = 0;
+
+                free(progress->occupancy);
+                progress->occupancy = NULL;
+            }
+            else
+                progress->nextPt = chunkLast;
+        }
+
+        if (budget > 0 && (GetTime() - startTime) * 1000 >= budget)
+            break;
+    }
+
+    EndScissorMode();
+
+    return progress->nextSeries >= plot->numSeries;
+}
+
+
+static void getGridSteps(const Plot *plot, const ScreenTransform *transform, double *xStep, double *yStep, Point *startPt)
+{
+    const Rectangle clientRect = getClientRect(plot);
+
+    const double xSpan =  clientRect.width  / transform->xScale;
+    const double ySpan = -clientRect.height / transform->yScale;
+
+    *xStep = pow(10.0, floor(log10(xSpan / plot->grid.xNumLines)));
+    *yStep = pow(10.0, floor(log10(ySpan / plot->grid.yNumLines)));
+
+    while (xSpan / *xStep > 2.0 * plot->grid.xNumLines)
+        *xStep *= 2.0;
+
+    while (ySpan / *yStep > 2.0 * plot->grid.yNumLines)
+        *yStep *= 2.0;    
+
+    const Point minPt = getGraphPoint((Vector2){clientRect.x, clientRect.y + clientRect.height}, transform);
+    *startPt = (Point){ceil(minPt.x / *xStep) * *xStep, ceil(minPt.y / *yStep) * *yStep};
+}
+
+
+enum
+{
+    LABEL_CACHE_SIZE = 1024,
+    MAX_LABEL_LENGTH = 32
+};
+
+
+typedef struct
+{
+    double value;
+    int decimals, fontSize;
+    const GlyphInfo *fontGlyphs;
+    bool used;
+    float width;
+    char text[MAX_LABEL_LENGTH];
+} CachedLabel;
+
+
+// Tick labels keep their values while the view is static or panned by whole steps, so their text and width are cached
+static CachedLabel labelCache[LABEL_CACHE_SIZE];
+
+
+// Replacement for the "%.*f" format: the scaled value is rounded to an integer and its digits are written directly
+static void formatFixed(char *buf, int size, double value, int decimals)
+{
+    static const double scales[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6};
+    const int numScales = sizeof(scales) / sizeof(scales[0]);
+
+    const double scaled = (decimals >= 0 && decimals < numScales) ? fabs(value) * scales[decimals] : NAN;
+
+    // Too large to be represented exactly, infinite, NaN, or too close to a rounding tie to decide without the exact decimal expansion
+    if (!(scaled < 1e15) || fabs(scaled - floor(scaled) - 0.5) < 1e-6)
+    {
+        snprintf(buf, size, "%.*f", decimals, value);
+        return;
+    }
+
+    uint64_t n = scaled + 0.5;
+
+    char digits[24];
+    int len = 0;
+
+    do
+    {
+        digits[len++] = '0' + n % 10;
+        n /= 10;
+    } while (n > 0 || len <= decimals);
+
+    if (len + 3 > size)
+    {
+        snprintf(buf, size, "%.*f", decimals, value);
+        return;
+    }
+
+    char *ch = buf;
+
+    // No "-0.00"
+    if (value < 0 && scaled + 0.5 >= 1)
+        *ch++ = '-';
+
+    for (int i = len - 1; i >= 0; i--)
+    {
+        *ch++ = digits[i];
+        if (i == decimals && decimals > 0)
+            *ch++ = '.';
+    }
+
+    *ch = 0;
+}
+
+
+static const CachedLabel *getLabel(const Font *font, double value, int decimals, int fontSize)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint64_t hash = bits ^ ((uint64_t)decimals << 56) ^ ((uint64_t)fontSize << 40) ^ ((uint64_t)(uintptr_t)font->glyphs << 48);
+    hash *= 0x9E3779B97F4A7C15ull;
+
+    CachedLabel *label = &labelCache[hash >> 54 & (LABEL_CACHE_SIZE - 1)];
+
+    if (label->used && label->value == value && label->decimals == decimals && label->fontSize == fontSize && label->fontGlyphs == font->glyphs)
+        return label;
+
+    // Direct-mapped: a colliding label simply replaces the previous one
+    label->value = value;
+    label->decimals = decimals;
+    label->fontSize = fontSize;
+    label->fontGlyphs = font->glyphs;
+    label->used = true;
+
+    formatFixed(label->text, MAX_LABEL_LENGTH, value, decimals);
+    label->width = MeasureTextEx(*font, label->text, fontSize, 1).x;
+
+    return label;
+}
+
+
+static void drawGrid(const Plot *plot, const ScreenTransform *transform, const Font *font, int *maxYLabelWidth)
+{
+    if (maxYLabelWidth)
+        *maxYLabelWidth = 0;
+
+    if (plot->grid.xNumLines <= 0 || plot->grid.yNumLines <= 0)
+        return;
+
+    const Rectangle clientRect = getClientRect(plot);
+
+    double xStep, yStep;
+    Point startPt;
+    getGridSteps(plot, transform, &xStep, &yStep, &startPt);
+
+    Vector2 startPtScreen = getScreenPoint(startPt, transform);
+
+    // Vertical grid
+    for (int i = 0, x = startPtScreen.x; x < clientRect.x + clientRect.width; i++, x = startPtScreen.x + i * xStep * transform->xScale)
+    {
+        // Line
+        if (plot->grid.visible)
+            DrawLineEx((Vector2){x, clientRect.y}, (Vector2){x, clientRect.y + clientRect.height}, 1, *(Color *)&plot->grid.color);
+
+        // Label
+        if (plot->grid.labelled)
+        {
+            const CachedLabel *cachedLabel = getLabel(font, startPt.x + i * xStep, (xStep > 0.01) ? 2 : 4, plot->grid.fontSize);
+            const char *label = cachedLabel->text;
+            const int labelWidth = cachedLabel->width;
+
+            const int labelX = x - labelWidth / 2;
+            const int labelY = clientRect.y + clientRect.height + plot->grid.fontSize;
+
+            drawText(plot, font, label, (Vector2){labelX, labelY}, 0, plot->grid.fontSize, plot->grid.color);            
+        }
+    }
+
+    // Horizontal grid
+    for (int j = 0, y = startPtScreen.y; y > clientRect.y; j++, y = startPtScreen.y + j * yStep * transform->yScale)
+    {
+        // Line
+        if (plot->grid.visible)
+            DrawLineEx((Vector2){clientRect.x, y}, (Vector2){clientRect.x + clientRect.width, y}, 1, *(Color *)&plot->grid.color);
+
+        // Label
+        if (plot->grid.labelled)
+        {
+            const CachedLabel *cachedLabel = getLabel(font, startPt.y + j * yStep, (yStep > 0.01) ? 2 : 4, plot->grid.fontSize);
+            const char *label = cachedLabel->text;
+            const int labelWidth = cachedLabel->width;
+
+            const int labelX = clientRect.x - labelWidth - plot->grid.fontSize;
+            const int labelY = y - plot->grid.fontSize / 2;
+
+            drawText(plot, font, label, (Vector2){labelX, labelY}, 0, plot->grid.fontSize, plot->grid.color);
+
+            if (maxYLabelWidth && labelWidth > *maxYLabelWidth)
+                *maxYLabelWidth = labelWidth;                       
+        }
+    }
+}
+
+
+static void drawTitles(const Plot *plot, const ScreenTransform *transform, const Font *font, int maxYLabelWidth)
+{
+    if (!plot->titles.visible)
+        return;
+
+    Rectangle clientRect = getClientRect(plot);
+
+    // Horizontal axis
+    if (plot->titles.x && TextLength(plot->titles.x) > 0)
+    {
+        const int titleWidth = MeasureTextEx(*font, plot->titles.x, plot->titles.fontSize, 1).x;
+
+        const int titleX = clientRect.x + clientRect.width / 2 - titleWidth / 2;
+        const int titleY = clientRect.y + clientRect.height + 2 * plot->grid.fontSize + plot->titles.fontSize;
+
+        drawText(plot, font, plot->titles.x, (Vector2){titleX, titleY}, 0, plot->titles.fontSize, plot->titles.color);
+    }
+
+    // Vertical axis
+    if (plot->titles.y && TextLength(plot->titles.y) > 0)
+    {
+        const int titleWidth = MeasureTextEx(*font, plot->titles.y, plot->titles.fontSize, 1).x;
+
+        const int titleX = clientRect.x - 2 * plot->grid.fontSize - plot->titles.fontSize - maxYLabelWidth;
+        const int titleY = clientRect.y + clientRect.height / 2 + titleWidth / 2;
+
+        drawText(plot, font, plot->titles.y, (Vector2){titleX, titleY}, -90.0, plot->titles.fontSize, plot->titles.color);
+    }
+
+    // Graph
+    if (plot->titles.graph && TextLength(plot->titles.graph) > 0)
+    {
+        const int titleWidth = MeasureTextEx(*font, plot->titles.graph, plot->titles.fontSize, 1).x;
+
+        const int titleX = clientRect.x + clientRect.width / 2 - titleWidth / 2;
+        const int titleY = clientRect.y - 2 * plot->titles.fontSize;
+
+        drawText(plot, font, plot->titles.graph, (Vector2){titleX, titleY}, 0, plot->titles.fontSize, plot->titles.color);
+    }        
+}
+
+
+static void drawLegend(const Plot *plot, const Font *font)
+{
+    if (!plot->legend.visible)
+        return;    
+
+    const int dashLength = 20, margin = 20;
+
+    const Rectangle legendRect = getLegendRect(plot);
+    const PlotCache *metrics = getLegendMetrics(plot);
+    if (!metrics)
+        return;
+
+    // Only the rows within the legend rectangle are drawn, whatever the number of series
+    int64_t firstRow, lastRow;
+    getVisibleLegendRows(plot, metrics, &legendRect, &firstRow, &lastRow);
+
+    BeginScissorMode(legendRect.x, legendRect.y, legendRect.width, legendRect.height);
+
+    for (int64_t iRow = firstRow; iRow < lastRow; iRow++)
+    {
+        const LegendRow *row = &metrics->legendRows[iRow];
+        const Series *series = &plot->series[row->firstSeries];
+        const Rectangle rowRect = getLegendRowRect(plot, metrics, &legendRect, iRow);
+        
+        // Legend mark
+        switch (series->style.kind)
+        {
+            case STYLE_LINE:
+            {
+                Vector2 dashPt1 = (Vector2){rowRect.x + margin, rowRect.y + plot->grid.fontSize / 2};
+                Vector2 dashPt2 = dashPt1;
+                dashPt2.x += dashLength;
+
+                DrawLineEx(dashPt1, dashPt2, series->style.width, *(Color *)&series->style.color);
+                break;
+            }
+
+            case STYLE_SCATTER:
+            case STYLE_SPLAT:
+            {
+                Vector2 pt = (Vector2){rowRect.x + margin + dashLength / 2, rowRect.y + plot->grid.fontSize / 2};
+
+                DrawCircleV(pt, series->style.width, *(Color *)&series->style.color);
+                break;
+            }
+
+            case STYLE_HISTOGRAM:
+            {
+                DrawRectangle(rowRect.x + margin, rowRect.y + plot->grid.fontSize / 4, dashLength, plot->grid.fontSize / 2, *(Color *)&series->style.color);
+                break;
+            }
+
+            case STYLE_DENSITY:
+            case STYLE_LINE_DENSITY:
+            case STYLE_IMAGE:
+            {
+                // Colormap bar
+                const Color *colormap = getColormap();
+                const int barX = rowRect.x + margin, barY = rowRect.y + plot->grid.fontSize / 4;
+
+                for (int i = 0; i < dashLength; i++)
+                    DrawRectangle(barX + i, barY, 1, plot->grid.fontSize / 2, colormap[i * (COLORMAP_SIZE - 1) / (dashLength - 1)]);
+                break;
+            }
+
+            default: break;
+        }
+
+        // Legend text
+        const int labelX = rowRect.x + dashLength + 2 * margin;
+        const int labelY = rowRect.y;
+        const char *label = row->label ? row->label : series->name;
+
+        if (label)
+            drawText(plot, font, label, (Vector2){labelX, labelY}, 0, plot->grid.fontSize, plot->grid.color);  
+    }
+
+    EndScissorMode();
+
+    // Scroll bar
+    const float contentHeight = metrics->numLegendRows * getLegendRowHeight(plot);
+
+    if (contentHeight > legendRect.height)
+    {
+        const float barHeight = legendRect.height * legendRect.height / contentHeight;
+        const float barY = legendRect.y + metrics->legendScroll * legendRect.height / contentHeight;
+
+        DrawRectangleRec((Rectangle){legendRect.x + legendRect.width - 4, barY, 3, barHeight}, LIGHTGRAY);
+    }
+}
+
+
+static void drawHoverPoint(const Plot *plot, const ScreenTransform *transform, const Font *font, Vector2 pos)
+{
+    const Rectangle clientRect = getClientRect(plot);
+    if (!CheckCollisionPointRec(pos, clientRect))
+        return;
+
+    const float hoverRadius = 10;
+
+    int64_t iSeries, iPt;
+    if (!findNearestPoint(plot, transform, pos, hoverRadius, &iSeries, &iPt))
+        return;
+
+    const Series *series = &plot->series[iSeries];
+    const Point pt = series->points[iPt];
+    const Vector2 screenPt = getScreenPoint(pt, transform);
+
+    // Crosshair
+    DrawLineEx((Vector2){clientRect.x, screenPt.y}, (Vector2){clientRect.x + clientRect.width, screenPt.y}, 1, LIGHTGRAY);
+    DrawLineEx((Vector2){screenPt.x, clientRect.y}, (Vector2){screenPt.x, clientRect.y + clientRect.height}, 1, LIGHTGRAY);
+    DrawCircleV(screenPt, series->style.width + 2, *(Color *)&series->style.color);
+
+    // Tooltip
+    const char *text = TextFormat("%s%s(%g, %g)", series->name ? series->name : "", (series->name && series->name[0]) ? ": " : "", pt.x, pt.y);
+    const Vector2 textSize = MeasureTextEx(*font, text, plot->grid.fontSize, 1);
+    const int padding = 4;
+
+    Rectangle tooltipRect = {screenPt.x + 2 * padding, screenPt.y - textSize.y - 4 * padding, textSize.x + 2 * padding, textSize.y + 2 * padding};
+
+    if (tooltipRect.x + tooltipRect.width > clientRect.x + clientRect.width)
+        tooltipRect.x = screenPt.x - 2 * padding - tooltipRect.width;
+
+    if (tooltipRect.y < clientRect.y)
+        tooltipRect.y = screenPt.y + 2 * padding;
+
+    DrawRectangleRec(tooltipRect, WHITE);
+    DrawRectangleLinesEx(tooltipRect, 1, *(Color *)&plot->grid.color);
+    drawText(plot, font, text, (Vector2){tooltipRect.x + padding, tooltipRect.y + padding}, 0, plot->grid.fontSize, plot->grid.color);
+}
+
+
+static Rectangle getNormalizedRect(Rectangle rect)
+{
+    if (rect.width < 0)
+    {
+        rect.x += rect.width;
+        rect.width *= -1;
+    }
+    if (rect.height < 0)
+    {
+        rect.y += rect.height;
+        rect.height *= -1;
+    }
+    return rect;
+}
+
+
+static void drawZoomRect(Rectangle zoomRect, const ScreenTransform *transform)
+{
+    DrawRectangleLinesEx(getNormalizedRect(zoomRect), 1, GRAY);
+}
+
+
+static void drawSelection(const Plot *plot, const ScreenTransform *transform, const Font *font, const Point *minPt, const Point *maxPt)
+{
+    const Rectangle clientRect = getClientRect(plot);
+
+    // Selection box, kept in graph coordinates so that it follows zooming and panning
+    const Vector2 corner1 = getScreenPoint(*minPt, transform);
+    const Vector2 corner2 = getScreenPoint(*maxPt, transform);
+    const Rectangle selectRect = getNormalizedRect((Rectangle){corner1.x, corner1.y, corner2.x - corner1.x, corner2.y - corner1.y});
+
+    BeginScissorMode(clientRect.x, clientRect.y, clientRect.width, clientRect.height);
+    DrawRectangleRec(selectRect, Fade(SKYBLUE, 0.2));
+    DrawRectangleLinesEx(selectRect, 1, BLUE);
+    EndScissorMode();
+
+    // Statistics of y for each series
+    const int padding = 4;
+    const int lineHeight = plot->grid.fontSize + padding;
+    const int maxLines = (clientRect.height - 2 * padding) / lineHeight;
+
+    Vector2 textPos = {clientRect.x + 2 * padding, clientRect.y + 2 * padding};
+    int numLines = 0;
+
+    for (int iSeries = 0; iSeries < numSelectionSeries && numLines < maxLines; iSeries++)
+    {
+        const SeriesSelection *sel = &selection[iSeries];
+        if (sel->numIndices == 0)
+            continue;
+
+        const char *name = plot->series[iSeries].name;
+        const char *text = TextFormat("%s%sn = %lld, mean = %g, min = %g, max = %g", name ? name : "", (name && name[0]) ? ": " : "", 
+                                      (long long)sel->numIndices, sel->sum / sel->numIndices, sel->min, sel->max);
+
+        const Vector2 textSize = MeasureTextEx(*font, text, plot->grid.fontSize, 1);
+        DrawRectangleRec((Rectangle){textPos.x - padding, textPos.y - padding / 2, textSize.x + 2 * padding, lineHeight}, Fade(WHITE, 0.8));
+        drawText(plot, font, text, textPos, 0, plot->grid.fontSize, plot->series[iSeries].style.color);
+
+        textPos.y += lineHeight;
+        numLines++;
+    }
+}
+
+
+static void drawPlot(const Plot *plot, const ScreenTransform *transform, const Font *gridFont, const Font *titlesFont, bool preview, const Texture2D *dataLayer)
+{
+    // Border
+    DrawRectangleLinesEx(getClientRect(plot), 1, BLACK);
+
+    // Grid
+    int maxYLabelWidth = 0;
+
+    beginText(plot);
+    drawGrid(plot, transform, gridFont, &maxYLabelWidth);
+    endText(plot);
+
+    // Graph
+    if (dataLayer)
+    {
+        BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+        DrawTextureRec(*dataLayer, (Rectangle){0, 0, dataLayer->width, -dataLayer->height}, (Vector2){canvas.x, canvas.y}, WHITE);
+        EndBlendMode();
+    }
+    else
+        drawGraph(plot, transform, NULL, preview);
+
+    // Titles and legend
+    beginText(plot);
+    drawTitles(plot, transform, titlesFont, maxYLabelWidth);
+    drawLegend(plot, gridFont);
+    endText(plot);
+}
+
+
+// A single atlas is shared when the grid and titles font sizes are equal, or for all sizes in the SDF mode
+static void getFonts(const Plot *plot, Font *gridFont, Font *titlesFont)
+{
+    *gridFont = getFont(plot->grid.fontSize, plot->fonts.sdf);
+    *titlesFont = getFont(plot->titles.fontSize, plot->fonts.sdf);
+}
+
+
+static void writeSvgColor(FILE *file, const char *attrib, uint32_t color)
+{
+    const Color c = *(Color *)&color;
+    fprintf(file, " %s=\"rgb(%d,%d,%d)\" %s-opacity=\"%.3f\"", attrib, c.r, c.g, c.b, attrib, c.a / 255.0);
+}
+
+
+static void writeSvgText(FILE *file, const char *text, double x, double y, double rotation, const char *anchor, int64_t fontSize, uint32_t color)
+{
+    fprintf(file, "<text x=\"%.2f\" y=\"%.2f\" font-family=\"Liberation Sans, Arial, sans-serif\" font-size=\"%lld\" text-anchor=\"%s\" dominant-baseline=\"hanging\"", 
+            x, y, (long long)fontSize, anchor);
+
+    if (rotation != 0)
+        fprintf(file, " transform=\"rotate(%.2f %.2f %.2f)\"", rotation, x, y);
+
+    writeSvgColor(file, "fill", color);
+    fprintf(file, ">");
+
+    for (const char *ch = text; *ch; ch++)
+    {
+        switch (*ch)
+        {
+            case '<':  fprintf(file, "&lt;");   break;
+            case '>':  fprintf(file, "&gt;");   break;
+            case '&':  fprintf(file, "&amp;");  break;
+            case '"':  fprintf(file, "&quot;"); break;
+            default:   fputc(*ch, file);        break;
+        }
+    }
+
+    fprintf(file, "</text>\n");
+}
+
+
+// Vector counterpart of drawPlot(): the layout, transform and grid are computed exactly as for the raster output
+enum
+{
+    MAX_SVG_IMAGE_CELLS = 65536     // Larger image series are written with a cell for every few cells in each direction
+};
+
+
+static void writeSvgImage(FILE *file, const Series *series, const ScreenTransform *transform)
+{
+    const ImageData *image = &series->image;
+
+    if (series->numPoints < 2 || !image->values || image->numRows <= 0 || image->numCols <= 0)
+        return;
+
+    double minValue, maxValue;
+    getImageRange(image, &minValue, &maxValue);
+    const double scale = (maxValue > minValue) ? COLORMAP_SIZE / (maxValue - minValue) : 0;
+
+    int64_t step = 1;
+    while (image->numRows * image->numCols / (step * step) > MAX_SVG_IMAGE_CELLS)
+        step *= 2;
+
+    const double minX = fmin(series->points[0].x, series->points[1].x), maxX = fmax(series->points[0].x, series->points[1].x);
+    const double minY = fmin(series->points[0].y, series->points[1].y), maxY = fmax(series->points[0].y, series->points[1].y);
+    const double cellWidth = (maxX - minX) / image->numCols, cellHeight = (maxY - minY) / image->numRows;
+
+    fprintf(file, "<g shape-rendering=\"crispEdges\">\n");
+
+    for (int64_t row = 0; row < image->numRows; row += step)
+        for (int64_t col = 0; col < image->numCols; col += step)
+        {
+            const double value = image->values[row * image->numCols + col];
+            if (value != value)
+                continue;
+
+            const Color color = getImageColor(value, minValue, scale);
+
+            const Vector2 pt1 = getScreenPoint((Point){minX + col * cellWidth, maxY - row * cellHeight}, transform);
+            const Vector2 pt2 = getScreenPoint((Point){minX + (col + step) * cellWidth, maxY - (row + step) * cellHeight}, transform);
+
+            fprintf(file, "<rect x=\"%.2f\" y=\"%.2f\" width=\"%.2f\" height=\"%.2f\"", fminf(pt1.x, pt2.x), fminf(pt1.y, pt2.y), fabsf(pt2.x - pt1.x), fabsf(pt2.y - pt1.y));
+            writeSvgColor(file, "fill", *(uint32_t *)&color);
+            fprintf(file, "/>\n");
+        }
+
+    fprintf(file, "</g>\n");
+}
+
+
+// Styles meant for millions of points are rendered on the CPU as for the window, and embedded as a single PNG image 
+// rather than as an element per point
+static void writeSvgRaster(FILE *file, const Plot *plot, int iSeries, const ScreenTransform *transform, const Rectangle *clientRect)
+{
+    const Series *series = &plot->series[iSeries];
+    const Rectangle rect = {floorf(clientRect->x), floorf(clientRect->y), ceilf(clientRect->width), ceilf(clientRect->height)};
+
+    Color *pixels = malloc((rect.width * rect.height > 0 ? rect.width * rect.height : 1) * sizeof(Color));
+    if (!pixels)
+        return;
+
+    bool ok = false;
+
+    if (series->style.kind == STYLE_DENSITY)
+        ok = renderDensity(series, transform, &rect, 0, series->numPoints, pixels);
+    else if (series->style.kind == STYLE_SPLAT)
+        ok = renderSplats(series, transform, &rect, 0, series->numPoints, pixels);
+    else if (series->style.kind == STYLE_LINE_DENSITY)
+    {
+        int64_t numSpans = 0;
+        PointSpan *spans = getLineDensitySpans(plot, NULL, &numSpans);
+
+        ok = spans && renderLineDensity(spans, numSpans, transform, &rect, pixels);
+        free(spans);
+    }
+
+    unsigned char *png = NULL;
+    char *base64 = NULL;
+    int pngSize = 0, base64Size = 0;
+
+    if (ok)
+        png = ExportImageToMemory((Image){pixels, rect.width, rect.height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8}, ".png", &pngSize);
+
+    if (png)
+        base64 = EncodeDataBase64(png, pngSize, &base64Size);
+
+    if (base64)
+    {
+        fprintf(file, "<image x=\"%.2f\" y=\"%.2f\" width=\"%.2f\" height=\"%.2f\" style=\"image-rendering:pixelated\" href=\"data:image/png;base64,", 
+                rect.x, rect.y, rect.width, rect.height);
+        fwrite(base64, 1, base64Size, file);
+        fprintf(file, "\"/>\n");
+    }
+
+    MemFree(base64);
+    MemFree(png);
+    free(pixels);
+}
+
+
+static bool writeSvg(const Plot *plot, const ScreenTransform *transform, const Font *gridFont, const char *fileName)
+{
+    FILE *file = fopen(fileName, "w");
+    if (!file)
+        return false;
+
+    fprintf(file, "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%d\" viewBox=\"%.2f %.2f %.2f %.2f\">\n", 
+            (int)canvas.width, (int)canvas.height, canvas.x, canvas.y, canvas.width, canvas.height);
+
+    fprintf(file, "<rect x=\"%.2f\" y=\"%.2f\" width=\"%.2f\" height=\"%.2f\" fill=\"white\"/>\n", canvas.x, canvas.y, canvas.width, canvas.height);
+
+    const Rectangle clientRect = getClientRect(plot);
+
+    fprintf(file, "<clipPath id=\"client\"><rect x=\"%.2f\" y=\"%.2f\" width=\"%.2f\" height=\"%.2f\"/></clipPath>\n", 
+            clientRect.x, clientRect.y, clientRect.width, clientRect.height);
+
+    // Border
+    fprintf(file, "<rect x=\"%.2f\" y=\"%.2f\" width=\"%.2f\" height=\"%.2f\" fill=\"none\" stroke=\"black\"/>\n", 
+            clientRect.x, clientRect.y, clientRect.width, clientRect.height);
+
+    // Grid
+    int maxYLabelWidth = 0;
+
+    if (plot->grid.xNumLines > 0 && plot->grid.yNumLines > 0)
+    {
+        double xStep, yStep;
+        Point startPt;
+        getGridSteps(plot, transform, &xStep, &yStep, &startPt);
+
+        const Vector2 startPtScreen = getScreenPoint(startPt, transform);
+
+        for (int i = 0, x = startPtScreen.x; x < clientRect.x + clientRect.width; i++, x = startPtScreen.x + i * xStep * transform->xScale)
+        {
+            if (plot->grid.visible)
+            {
+                fprintf(file, "<line x1=\"%d\" y1=\"%.2f\" x2=\"%d\" y2=\"%.2f\"", x, clientRect.y, x, clientRect.y + clientRect.height);
+                writeSvgColor(file, "stroke", plot->grid.color);
+                fprintf(file, "/>\n");
+            }
+
+            if (plot->grid.labelled)
+            {
+                const char *label = getLabel(gridFont, startPt.x + i * xStep, (xStep > 0.01) ? 2 : 4, plot->grid.fontSize)->text;
+                writeSvgText(file, label, x, clientRect.y + clientRect.height + plot->grid.fontSize, 0, "middle", plot->grid.fontSize, plot->grid.color);
+            }
+        }
+
+        for (int j = 0, y = startPtScreen.y; y > clientRect.y; j++, y = startPtScreen.y + j * yStep * transform->yScale)
+        {
+            if (plot->grid.visible)
+            {
+                fprintf(file, "<line x1=\"%.2f\" y1=\"%d\" x2=\"%.2f\" y2=\"%d\"", clientRect.x, y, clientRect.x + clientRect.width, y);
+                writeSvgColor(file, "stroke", plot->grid.color);
+                fprintf(file, "/>\n");
+            }
+
+            if (plot->grid.labelled)
+            {
+                const CachedLabel *cachedLabel = getLabel(gridFont, startPt.y + j * yStep, (yStep > 0.01) ? 2 : 4, plot->grid.fontSize);
+                const char *label = cachedLabel->text;
+                const int labelWidth = cachedLabel->width;
+
+                writeSvgText(file, label, clientRect.x - plot->grid.fontSize, y - plot->grid.fontSize / 2, 0, "end", plot->grid.fontSize, plot->grid.color);
+
+                if (labelWidth > maxYLabelWidth)
+                    maxYLabelWidth = labelWidth;                
+            }
+        }
+    }
+
+    // Graph
+    fprintf(file, "<g clip-path=\"url(#client)\">\n");
+
+    for (int iSeries = 0; iSeries < plot->numSeries; iSeries++)
+    {
+        const Series *series = &plot->series[iSeries];
+
+        switch (series->style.kind)
+        {
+            case STYLE_LINE:
+            {
+                if (series->numPoints > 1)
+                {
+                    fprintf(file, "<polyline fill=\"none\" stroke-width=\"%.2f\" stroke-linejoin=\"round\"", series->style.width);
+                    writeSvgColor(file, "stroke", series->style.color);
+                    fprintf(file, " points=\"");
+
+                    for (int64_t iPt = 0; iPt < series->numPoints; iPt++)
+                    {
+                        const Vector2 pt = getScreenPoint(series->points[iPt], transform);
+                        fprintf(file, "%.2f,%.2f ", pt.x, pt.y);
+                    }
+
+                    fprintf(file, "\"/>\n");
+                }
+                break;
+            }
+
+            case STYLE_IMAGE:
+            {
+                writeSvgImage(file, series, transform);
+                break;
+            }
+
+            case STYLE_HISTOGRAM:
+            {
+                fprintf(file, "<g");
+                writeSvgColor(file, "fill", series->style.color);
+                fprintf(file, ">\n");
+
+                const double baseY = getScreenPoint((Point){0, 0}, transform).y;
+
+                for (int64_t iPt = 0; iPt < series->numPoints; iPt++)
+                {
+                    const Vector2 pt = getScreenPoint(series->points[iPt], transform);
+                    const double right = getScreenPoint((Point){getHistogramBinRight(series, iPt), 0}, transform).x;
+
+                    fprintf(file, "<rect x=\"%.2f\" y=\"%.2f\" width=\"%.2f\" height=\"%.2f\"/>\n", pt.x, fmin(pt.y, baseY), right - pt.x, fabs(pt.y - baseY));
+                }
+
+                fprintf(file, "</g>\n");
+                break;
+            }
+
+            case STYLE_DENSITY:
+            case STYLE_SPLAT:
+            {
+                writeSvgRaster(file, plot, iSeries, transform, &clientRect);
+                break;
+            }
+
+            case STYLE_LINE_DENSITY:
+            {
+                // All series with the line density style are rendered together, in place of the first of them
+                bool first = true;
+                for (int i = 0; i < iSeries && first; i++)
+                    first = plot->series[i].style.kind != STYLE_LINE_DENSITY;
+
+                if (first)
+                    writeSvgRaster(file, plot, iSeries, transform, &clientRect);
+                break;
+            }
+
+            case STYLE_SCATTER:
+            {
+                fprintf(file, "<g");
+                writeSvgColor(file, "fill", series->style.color);
+                fprintf(file, ">\n");
+
+                for (int64_t iPt = 0; iPt < series->numPoints; iPt++)
+                {
+                    const Vector2 pt = getScreenPoint(series->points[iPt], transform);
+                    fprintf(file, "<circle cx=\"%.2f\" cy=\"%.2f\" r=\"%.2f\"/>\n", pt.x, pt.y, series->style.width);
+                }
+
+                fprintf(file, "</g>\n");
+                break;
+            }
+
+            default: break;
+        }
+    }
+
+    fprintf(file, "</g>\n");
+
+    // Titles
+    if (plot->titles.visible)
+    {
+        if (plot->titles.x && TextLength(plot->titles.x) > 0)
+            writeSvgText(file, plot->titles.x, clientRect.x + clientRect.width / 2, clientRect.y + clientRect.height + 2 * plot->grid.fontSize + plot->titles.fontSize, 
+                         0, "middle", plot->titles.fontSize, plot->titles.color);
+
+        if (plot->titles.y && TextLength(plot->titles.y) > 0)
+            writeSvgText(file, plot->titles.y, clientRect.x - 2 * plot->grid.fontSize - plot->titles.fontSize - maxYLabelWidth, clientRect.y + clientRect.height / 2, 
+                         -90, "middle", plot->titles.fontSize, plot->titles.color);
+
+        if (plot->titles.graph && TextLength(plot->titles.graph) > 0)
+            writeSvgText(file, plot->titles.graph, clientRect.x + clientRect.width / 2, clientRect.y - 2 * plot->titles.fontSize, 
+                         0, "middle", plot->titles.fontSize, plot->titles.color);
+    }
+
+    // Legend
+    if (plot->legend.visible)
+    {
+        const int dashLength = 20, margin = 20;
+        const Rectangle legendRect = getLegendRect(plot);
+
+        const PlotCache *metrics = getLegendMetrics(plot);
+
+        int64_t firstRow = 0, lastRow = 0;
+        if (metrics)
+            getVisibleLegendRows(plot, metrics, &legendRect, &firstRow, &lastRow);
+
+        for (int64_t iRow = firstRow; iRow < lastRow; iRow++)
+        {
+            const LegendRow *row = &metrics->legendRows[iRow];
+            const Series *series = &plot->series[row->firstSeries];
+            const Rectangle rowRect = getLegendRowRect(plot, metrics, &legendRect, iRow);
+            const double markY = rowRect.y + plot->grid.fontSize / 2;
+
+            switch (series->style.kind)
+            {
+                case STYLE_LINE:
+                case STYLE_LINE_DENSITY:
+                {
+                    fprintf(file, "<line x1=\"%.2f\" y1=\"%.2f\" x2=\"%.2f\" y2=\"%.2f\" stroke-width=\"%.2f\"", 
+                            rowRect.x + margin, markY, rowRect.x + margin + dashLength, markY, series->style.width);
+                    writeSvgColor(file, "stroke", series->style.color);
+                    fprintf(file, "/>\n");
+                    break;
+                }
+
+                case STYLE_HISTOGRAM:
+                {
+                    fprintf(file, "<rect x=\"%.2f\" y=\"%.2f\" width=\"%d\" height=\"%.2f\"", 
+                            rowRect.x + margin, markY - plot->grid.fontSize / 4.0, dashLength, plot->grid.fontSize / 2.0);
+                    writeSvgColor(file, "fill", series->style.color);
+                    fprintf(file, "/>\n");
+                    break;
+                }
+
+                case STYLE_SCATTER:
+                case STYLE_DENSITY:
+                case STYLE_SPLAT:
+                {
+                    fprintf(file, "<circle cx=\"%.2f\" cy=\"%.2f\" r=\"%.2f\"", rowRect.x + margin + dashLength / 2, markY, series->style.width);
+                    writeSvgColor(file, "fill", series->style.color);
+                    fprintf(file, "/>\n");
+                    break;
+                }
+
+                default: break;
+            }
+
+            const char *label = row->label ? row->label : series->name;
+
+            if (label)
+                writeSvgText(file, label, rowRect.x + dashLength + 2 * margin, rowRect.y, 0, "start", plot->grid.fontSize, plot->grid.color);
+        }
+    }
+
+    fprintf(file, "</svg>\n");
+    fclose(file);
+    return true;
+}
+
+
+enum
+{
+    MAX_ZOOM_HISTORY = 64,
+    MAX_CACHED_LAYERS = 8
+};
+
+
+// Views visited in the window, for stepping back and forward
+typedef struct
+{
+    ScreenTransform transforms[MAX_ZOOM_HISTORY];
+    int current, count;
+} ZoomHistory;
+
+
+static void resetZoomHistory(ZoomHistory *history, const ScreenTransform *transform)
+{
+    history->transforms[0] = *transform;
+    history->current = 0;
+    history->count = 1;
+}
+
+
+static void pushZoomHistory(ZoomHistory *history, const ScreenTransform *transform)
+{
+    if (memcmp(&history->transforms[history->current], transform, sizeof(ScreenTransform)) == 0)
+        return;
+
+    // Forward views are discarded, and the oldest one if the history is full
+    if (history->current == MAX_ZOOM_HISTORY - 1)
+    {
+        memmove(&history->transforms[0], &history->transforms[1], (MAX_ZOOM_HISTORY - 1) * sizeof(ScreenTransform));
+        history->current--;
+    }
+
+    history->transforms[++history->current] = *transform;
+    history->count = history->current + 1;
+}
+
+
+static bool stepZoomHistory(ZoomHistory *history, int step, ScreenTransform *transform)
+{
+    const int next = history->current + step;
+    if (next < 0 || next >= history->count)
+        return false;
+
+    history->current = next;
+    *transform = history->transforms[next];
+    return true;
+}
+
+
+// Data layers rendered for recent views, so that returning to a view or redrawing an unchanged one costs a single texture draw
+typedef struct
+{
+    ScreenTransform transform;
+    RenderTexture2D target;
+    GraphProgress progress;
+    int64_t lastUsed;
+    bool valid, complete;
+} CachedLayer;
+
+
+typedef struct
+{
+    CachedLayer layers[MAX_CACHED_LAYERS];
+    int64_t numUses;
+} LayerCache;
+
+
+static void continueDataLayer(CachedLayer *layer, const Plot *plot, double budget)
+{
+    // The layer covers the canvas only, so the graph is drawn as if the canvas were at the origin
+    const Rectangle panelCanvas = canvas;
+
+    ScreenTransform transform = layer->transform;
+    transform.dx += canvas.x / transform.xScale;
+    transform.dy += canvas.y / transform.yScale;
+
+    canvas = (Rectangle){0, 0, panelCanvas.width, panelCanvas.height};
+
+    // Colors are accumulated premultiplied by alpha, with the alpha itself blended as coverage, so that the layer can be 
+    // composited over the background without applying translucent alphas twice
+    BeginTextureMode(layer->target);
+    rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD, RL_FUNC_ADD);
+    BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+
+    layer->complete = drawGraphProgressive(plot, &transform, &layer->progress, budget);
+
+    EndBlendMode();
+    EndTextureMode();
+
+    canvas = panelCanvas;
+}
+
+
+// Returns the data layer for the view, drawn as far as the time budget allows: incomplete layers are continued on the 
+// next calls, and a layer left incomplete by changing the view is resumed when the view is visited again
+static const Texture2D *getDataLayer(LayerCache *cache, const Plot *plot, const ScreenTransform *transform, double budget, bool *complete)
+{
+    const int width = canvas.width, height = canvas.height;
+    CachedLayer *layer = NULL;
+
+    *complete = true;
+
+    for (int iLayer = 0; iLayer < MAX_CACHED_LAYERS; iLayer++)
+    {
+        CachedLayer *candidate = &cache->layers[iLayer];
+
+        if (candidate->valid && memcmp(&candidate->transform, transform, sizeof(ScreenTransform)) == 0)
+        {
+            if (!candidate->complete)
+                continueDataLayer(candidate, plot, budget);
+
+            candidate->lastUsed = ++cache->numUses;
+            *complete = candidate->complete;
+            return &candidate->target.texture;
+        }
+
+        // Free slots first, then the least recently used one
+        if (!layer || (layer->valid && (!candidate->valid || candidate->lastUsed < layer->lastUsed)))
+            layer = candidate;
+    }
+
+    if (layer->target.id == 0 || layer->target.texture.width != width || layer->target.texture.height != height)
+    {
+        if (layer->target.id != 0)
+            UnloadRenderTexture(layer->target);
+
+        layer->target = LoadRenderTexture(width, height);
+        if (layer->target.id == 0)
+        {
+            layer->valid = false;
+            return NULL;
+        }
+    }
+
+    BeginTextureMode(layer->target);
+    ClearBackground(BLANK);
+    EndTextureMode();
+
+    layer->transform = *transform;
+    resetGraphProgress(&layer->progress);
+    layer->lastUsed = ++cache->numUses;
+    layer->valid = true;
+
+    continueDataLayer(layer, plot, budget);
+
+    *complete = layer->complete;
+    return &layer->target.texture;
+}
+
+
+static void invalidateDataLayers(LayerCache *cache)
+{
+    for (int iLayer = 0; iLayer < MAX_CACHED_LAYERS; iLayer++)
+        cache->layers[iLayer].valid = false;
+}
+
+
+static void unloadDataLayers(LayerCache *cache)
+{
+    for (int iLayer = 0; iLayer < MAX_CACHED_LAYERS; iLayer++)
+    {
+        if (cache->layers[iLayer].target.id != 0)
+            UnloadRenderTexture(cache->layers[iLayer].target);
+
+        resetGraphProgress(&cache->layers[iLayer].progress);
+    }
+
+    *cache = (LayerCache){0};
+}
+
+
+enum
+{
+    HISTOGRAM_PARALLEL_MIN_VALUES = 1 << 16
+};
+
+
+// Doubles the bin width of an adaptive histogram by merging pairs of neighboring bins, so that the range grows downwards 
+// or upwards by its current length
+static void expandHistogram(Histogram *hist, bool down)
+{
+    const int64_t half = hist->numBins / 2;
+
+    if (down)
+    {
+        // Bins are moved to the upper half, reading below the bin being written
+        for (int64_t i = hist->numBins - 1; i >= half; i--)
+            hist->counts[i] = hist->counts[2 * (i - half)] + hist->counts[2 * (i - half) + 1];
+        for (int64_t i = 0; i < half; i++)
+            hist->counts[i] = 0;
+
+        hist->min -= hist->numBins * hist->binWidth;
+    }
+    else
+    {
+        for (int64_t i = 0; i < half; i++)
+            hist->counts[i] = hist->counts[2 * i] + hist->counts[2 * i + 1];
+        for (int64_t i = half; i < hist->numBins; i++)
+            hist->counts[i] = 0;
+    }
+
+    hist->binWidth *= 2;
+}
+
+
+// Lets an adaptive histogram take in the range [min, max]
+static void fitHistogram(Histogram *hist, double min, double max)
+{
+    if (hist->numBins < 2 || !(hist->binWidth > 0))
+        return;
+
+    while (min < hist->min)
+        expandHistogram(hist, true);
+
+    while (max >= hist->min + hist->numBins * hist->binWidth)
+        expandHistogram(hist, false);
+}
+
+
+static int64_t getHistogramBin(const Histogram *hist, double value)
+{
+    const int64_t iBin = (value - hist->min) / hist->binWidth;
+    return (iBin < hist->numBins) ? iBin : hist->numBins - 1;
+}
+
+
+// Partial counts of a batch of values: each task bins its share of the values into its own counts
+typedef struct
+{
+    const Histogram *hist;
+    const double *values;
+    int64_t numValues;
+    int numTasks;
+    int64_t *counts;            // numTasks * (numBins + 2), with the underflow and the overflow last
+} HistogramTask;
+
+
+static void countHistogramValues(const Histogram *hist, const double *values, int64_t numValues, int64_t *counts, int64_t *underflow, int64_t *overflow)
+{
+    const double max = hist->min + hist->numBins * hist->binWidth;
+
+    for (int64_t i = 0; i < numValues; i++)
+    {
+        const double value = values[i];
+
+        if (value < hist->min)
+            (*underflow)++;
+        else if (value >= max)
+            (*overflow)++;
+        else if (value == value)
+            counts[getHistogramBin(hist, value)]++;
+    }
+}
+
+
+static void binHistogramValues(void *data, int64_t first, int64_t last)
+{
+    const HistogramTask *task = (const HistogramTask *)data;
+    const Histogram *hist = task->hist;
+
+    for (int64_t iTask = first; iTask < last; iTask++)
+    {
+        int64_t *counts = &task->counts[iTask * (hist->numBins + 2)];
+
+        const int64_t firstValue = task->numValues * iTask / task->numTasks;
+        const int64_t lastValue = task->numValues * (iTask + 1) / task->numTasks;
+
+        countHistogramValues(hist, &task->values[firstValue], lastValue - firstValue, counts, &counts[hist->numBins], &counts[hist->numBins + 1]);
+    }
+}
+
+
+UMPLOT_API void umplotInit(Plot *plot, Series *series, int64_t numSeries, int64_t kind)
+{
+    *plot = (Plot){.series = series, .numSeries = numSeries};
+
+    const uint32_t basicColors[] = {0xFF0000DD, 0xFFDD0000, 0xFF00DD00};
+    const int numBasicColors = sizeof(basicColors) / sizeof(basicColors[0]);
+
+    for (int iSeries = 0; iSeries < numSeries; iSeries++)
+    {
+        uint32_t color;
+        if (iSeries < numBasicColors)
+            color = basicColors[iSeries];
+        else
+        {
+            const int j = iSeries - numBasicColors;
+            color = (series[j].style.color + series[j + 1].style.color) / 2;
+        }
+
+        series[iSeries] = (Series){.name = "", .style = {.kind = kind, .color = color, .width = 3.0}};
+    }
+
+    plot->grid = (Grid){.xNumLines = 5, .yNumLines = 5, .color = 0xFF505050, .fontSize = 12, .visible = true, .labelled = true};
+    plot->titles = (Titles){.x = "", .y = "", .graph = "", .color = plot->grid.color, .fontSize = plot->grid.fontSize, .visible = true};
+    plot->legend = (Legend){.visible = true, .grouped = false};
+    plot->screenshot = (Screenshot){.fileName = "umplot"};
+    plot->fonts = (Fonts){.sdf = false};
+    plot->rendering = (Rendering){.frameBudget = 20.0};
+}
+
+
+// Interactive state of a plot shown in a window, alone or as a subplot
+typedef struct
+{
+    const Plot *plot;
+    Rectangle rect;                 // Part of the window used as the canvas for the plot
+    Rectangle clientRect;
+    Font gridFont, titlesFont;
+    ScreenTransform transform;
+    ZoomHistory history;
+    LayerCache layers;
+    const Texture2D *dataLayer;
+} Panel;
+
+
+static Rectangle getPanelRect(int iPanel, int numPanels, int numCols)
+{
+    const int numRows = (numPanels + numCols - 1) / numCols;
+    const float width = (float)GetScreenWidth() / numCols, height = (float)GetScreenHeight() / numRows;
+
+    return (Rectangle){(iPanel % numCols) * width, (iPanel / numCols) * height, width, height};
+}
+
+
+static int getPanelAt(const Panel *panels, int numPanels, Vector2 pos)
+{
+    for (int iPanel = 0; iPanel < numPanels; iPanel++)
+        if (CheckCollisionPointRec(pos, panels[iPanel].rect))
+            return iPanel;
+
+    return -1;
+}
+
+
+static void getVisibleRange(const Panel *panel, Point *minPt, Point *maxPt)
+{
+    canvas = panel->rect;
+    const Rectangle rect = getClientRect(panel->plot);
+
+    *minPt = getGraphPoint((Vector2){rect.x, rect.y + rect.height}, &panel->transform);
+    *maxPt = getGraphPoint((Vector2){rect.x + rect.width, rect.y}, &panel->transform);
+}
+
+
+static void setVisibleRange(Panel *panel, const Point *minPt, const Point *maxPt)
+{
+    canvas = panel->rect;
+    setTransformToMinMax(panel->plot, &panel->transform, minPt, maxPt);
+}
+
+
+// Applies the linked axis ranges of the source panel to all other panels. Panels whose transform does not change keep 
+// their cached data layers
+static void linkPanels(Panel *panels, int numPanels, int iSource, int link)
+{
+    if (!(link & (LINK_X | LINK_Y)) || numPanels < 2)
+        return;
+
+    Point sourceMinPt, sourceMaxPt;
+    getVisibleRange(&panels[iSource], &sourceMinPt, &sourceMaxPt);
+
+    for (int iPanel = 0; iPanel < numPanels; iPanel++)
+    {
+        if (iPanel == iSource)
+            continue;
+
+        Point minPt, maxPt;
+        getVisibleRange(&panels[iPanel], &minPt, &maxPt);
+
+        if (link & LINK_X)
+        {
+            minPt.x = sourceMinPt.x;
+            maxPt.x = sourceMaxPt.x;
+        }
+
+        if (link & LINK_Y)
+        {
+            minPt.y = sourceMinPt.y;
+            maxPt.y = sourceMaxPt.y;
+        }
+
+        setVisibleRange(&panels[iPanel], &minPt, &maxPt);
+    }
+
+    canvas = panels[iSource].rect;
+}
+
+
+// Shows the full data bounds in all panels, with the union of the bounds along the linked axes
+static void resetPanels(Panel *panels, int numPanels, int link)
+{
+    Point unionMinPt = { DBL_MAX,  DBL_MAX};
+    Point unionMaxPt = {-DBL_MAX, -DBL_MAX};
+
+    for (int iPanel = 0; iPanel < numPanels; iPanel++)
+    {
+        canvas = panels[iPanel].rect;
+        resetTransform(panels[iPanel].plot, &panels[iPanel].transform);
+
+        Point minPt, maxPt;
+        getVisibleRange(&panels[iPanel], &minPt, &maxPt);
+
+        if (minPt.x < unionMinPt.x)  unionMinPt.x = minPt.x;
+        if (minPt.y < unionMinPt.y)  unionMinPt.y = minPt.y;
+        if (maxPt.x > unionMaxPt.x)  unionMaxPt.x = maxPt.x;
+        if (maxPt.y > unionMaxPt.y)  unionMaxPt.y = maxPt.y;
+    }
+
+    for (int iPanel = 0; iPanel < numPanels && (link & (LINK_X | LINK_Y)); iPanel++)
+    {
+        Point minPt, maxPt;
+        getVisibleRange(&panels[iPanel], &minPt, &maxPt);
+
+        if (link & LINK_X)
+        {
+            minPt.x = unionMinPt.x;
+            maxPt.x = unionMaxPt.x;
+        }
+
+        if (link & LINK_Y)
+        {
+            minPt.y = unionMinPt.y;
+            maxPt.y = unionMaxPt.y;
+        }
+
+        setVisibleRange(&panels[iPanel], &minPt, &maxPt);
+    }
+}
+
+
+enum
+{
+    SPARKLINE_MIN_HEIGHT = 40,
+    SPARKLINE_PADDING = 4
+};
+
+
+typedef struct
+{
+    const Plot *plot;
+    PlotCache *cache;
+    const int64_t *series;      // Indices of the series to rebuild
+} SparklineTask;
+
+
+static void buildSparklines(void *data, int64_t first, int64_t last)
+{
+    const SparklineTask *task = (const SparklineTask *)data;
+    const int numColumns = task->cache->numSparklineColumns;
+
+    for (int64_t iTask = first; iTask < last; iTask++)
+    {
+        const int64_t iSeries = task->series[iTask];
+        const Series *series = &task->plot->series[iSeries];
+        SparklineColumn *columns = &task->cache->sparklineColumns[iSeries * numColumns];
+
+        Point minPt = (Point){ DBL_MAX,  DBL_MAX};
+        Point maxPt = (Point){-DBL_MAX, -DBL_MAX};
+
+        for (int64_t iPt = 0; iPt < series->numPoints; iPt++)
+        {
+            const Point *pt = &series->points[iPt];
+            if (!isFinitePoint(pt))
+                continue;
+
+            if (pt->x > maxPt.x)  maxPt.x = pt->x;
+            if (pt->x < minPt.x)  minPt.x = pt->x;
+            if (pt->y > maxPt.y)  maxPt.y = pt->y;
+            if (pt->y < minPt.y)  minPt.y = pt->y;
+        }
+
+        task->cache->sparklineRanges[iSeries] = (MinMax){minPt.y, maxPt.y};
+
+        for (int iColumn = 0; iColumn < numColumns; iColumn++)
+            columns[iColumn] = (SparklineColumn){.empty = true};
+
+        const double xScale = (maxPt.x > minPt.x) ? (numColumns - 1) / (maxPt.x - minPt.x) : 0;
+        const double yScale = (maxPt.y > minPt.y) ? 1.0 / (maxPt.y - minPt.y) : 0;
+
+        for (int64_t iPt = 0; iPt < series->numPoints; iPt++)
+        {
+            const Point *pt = &series->points[iPt];
+            if (!isFinitePoint(pt))
+                continue;
+
+            // Clamped in double, rounding may still step past the last column
+            double iColumn = (pt->x - minPt.x) * xScale;
+            iColumn = (iColumn >= 0) ? iColumn : 0;
+            iColumn = (iColumn < numColumns - 1) ? iColumn : numColumns - 1;
+
+            SparklineColumn *column = &columns[(int)iColumn];
+            const float y = (pt->y - minPt.y) * yScale;
+
+            if (column->empty)
+                *column = (SparklineColumn){y, y, y, y, false};
+            else
+            {
+                if (y < column->minY)  column->minY = y;
+                if (y > column->maxY)  column->maxY = y;
+                column->lastY = y;
+            }
+        }
+    }
+}
+
+
+// Reduces the series to the given number of columns. All series are reduced when the sparkline width changes, 
+// otherwise only those whose points have been replaced or appended to
+static bool updateSparklines(const Plot *plot, int numColumns)
+{
+    PlotCache *cache = getPlotCache(plot);
+    if (!cache)
+        return false;
+
+    if (!cache->sparklineColumns || cache->numSparklineColumns != numColumns || cache->numSparklineSeries != plot->numSeries)
+    {
+        free(cache->sparklineColumns);
+        free(cache->sparklineRanges);
+        free(cache->sparklineSpans);
+
+        cache->sparklineColumns = malloc((plot->numSeries * numColumns > 0 ? plot->numSeries * numColumns : 1) * sizeof(SparklineColumn));
+        cache->sparklineRanges = malloc((plot->numSeries > 0 ? plot->numSeries : 1) * sizeof(MinMax));
+        cache->sparklineSpans = malloc((plot->numSeries > 0 ? plot->numSeries : 1) * sizeof(PointSpan));
+        cache->numSparklineColumns = numColumns;
+        cache->numSparklineSeries = plot->numSeries;
+
+        if (!cache->sparklineColumns || !cache->sparklineRanges || !cache->sparklineSpans)
+        {
+            free(cache->sparklineColumns);
+            free(cache->sparklineRanges);
+            free(cache->sparklineSpans);
+            cache->sparklineColumns = NULL;
+            cache->sparklineRanges = NULL;
+            cache->sparklineSpans = NULL;
+            cache->numSparklineSeries = 0;
+            return false;
+        }
+
+        for (int64_t iSeries = 0; iSeries < plot->numSeries; iSeries++)
+            cache->sparklineSpans[iSeries] = (PointSpan){.lastPt = -1};
+    }
+
+    int64_t *changed = malloc((plot->numSeries > 0 ? plot->numSeries : 1) * sizeof(int64_t));
+    if (!changed)
+        return false;
+
+    int64_t numChanged = 0;
+
+    for (int64_t iSeries = 0; iSeries < plot->numSeries; iSeries++)
+    {
+        PointSpan *span = &cache->sparklineSpans[iSeries];
+        const Series *series = &plot->series[iSeries];
+
+        if (span->lastPt < 0 || span->points != series->points || span->lastPt != series->numPoints)
+        {
+            changed[numChanged++] = iSeries;
+            *span = (PointSpan){series->points, 0, series->numPoints};
+        }
+    }
+
+    SparklineTask task = {plot, cache, changed};
+    parallelFor(numChanged, 1, buildSparklines, &task);
+
+    free(changed);
+    return true;
+}
+
+
+static Rectangle getSparklineRect(const Plot *plot, int iSeries, int numCols, float scroll)
+{
+    const int numRows = (plot->numSeries + numCols - 1) / numCols;
+
+    float height = (float)GetScreenHeight() / (numRows > 0 ? numRows : 1);
+    if (height < SPARKLINE_MIN_HEIGHT)
+        height = SPARKLINE_MIN_HEIGHT;
+
+    const float width = (float)GetScreenWidth() / numCols;
+
+    return (Rectangle){(iSeries % numCols) * width, (iSeries / numCols) * height - scroll, width, height};
+}
+
+
+// Area of the sparkline below its label
+static Rectangle getSparklineGraphRect(const Plot *plot, Rectangle rect)
+{
+    const float top = rect.y + 1.5 * SPARKLINE_PADDING + plot->grid.fontSize;
+    const float height = rect.y + rect.height - SPARKLINE_PADDING - top;
+
+    return (Rectangle){rect.x + SPARKLINE_PADDING, top, rect.width - 2 * SPARKLINE_PADDING, height > 1 ? height : 1};
+}
+
+
+// All visible sparklines are drawn in two batches: the labels from the shared font atlas, then the lines as a single 
+// vertex stream
+static void drawSparklines(const Plot *plot, const Font *font, int numCols, float scroll)
+{
+    const PlotCache *cache = plot->cache;
+    const int numColumns = cache->numSparklineColumns;
+    const Color frameColor = LIGHTGRAY;
+
+    int firstVisible = 0, lastVisible = 0;
+    for (int iSeries = 0; iSeries < plot->numSeries; iSeries++)
+    {
+        const Rectangle rect = getSparklineRect(plot, iSeries, numCols, scroll);
+        if (rect.y + rect.height <= 0)
+            firstVisible = iSeries + 1;
+        else if (rect.y < GetScreenHeight())
+            lastVisible = iSeries + 1;
+        else
+            break;
+    }
+
+    for (int iSeries = firstVisible; iSeries < lastVisible; iSeries++)
+    {
+        const Rectangle rect = getSparklineRect(plot, iSeries, numCols, scroll);
+        const char *name = plot->series[iSeries].name;
+
+        if (name && name[0])
+            drawText(plot, font, name, (Vector2){rect.x + SPARKLINE_PADDING, rect.y + SPARKLINE_PADDING / 2}, 0, plot->grid.fontSize, plot->grid.color);
+    }
+
+    for (int iSeries = firstVisible; iSeries < lastVisible; iSeries++)
+    {
+        const Rectangle rect = getSparklineRect(plot, iSeries, numCols, scroll);
+        const Rectangle graphRect = getSparklineGraphRect(plot, rect);
+        const SparklineColumn *columns = &cache->sparklineColumns[iSeries * numColumns];
+        const Color color = *(Color *)&plot->series[iSeries].style.color;
+
+        // Frame, then a vertical y range per column joined to the previous column
+        rlCheckRenderBatchLimit(4 * numColumns + 8);
+        rlBegin(RL_LINES);
+
+        rlColor4ub(frameColor.r, frameColor.g, frameColor.b, frameColor.a);
+        rlVertex2f(rect.x, rect.y + rect.height);
+        rlVertex2f(rect.x + rect.width, rect.y + rect.height);
+        rlVertex2f(rect.x + rect.width, rect.y);
+        rlVertex2f(rect.x + rect.width, rect.y + rect.height);
+
+        rlColor4ub(color.r, color.g, color.b, color.a);
+
+        const float bottom = graphRect.y + graphRect.height;
+        float prevY = 0;
+        bool hasPrev = false;
+
+        for (int iColumn = 0; iColumn < numColumns; iColumn++)
+        {
+            const SparklineColumn *column = &columns[iColumn];
+            if (column->empty)
+                continue;
+
+            const float x = graphRect.x + iColumn + 0.5;
+
+            if (hasPrev)
+            {
+                rlVertex2f(x - 1, prevY);
+                rlVertex2f(x, bottom - column->firstY * graphRect.height);
+            }
+
+            rlVertex2f(x, bottom - column->maxY * graphRect.height);
+            rlVertex2f(x, bottom - column->minY * graphRect.height + 1);
+
+            prevY = bottom - column->lastY * graphRect.height;
+            hasPrev = true;
+        }
+
+        rlEnd();
+    }
+}
+
+
+static void drawSparklineReadout(const Plot *plot, const Font *font, int iSeries, Vector2 pos)
+{
+    const Series *series = &plot->series[iSeries];
+    if (series->numPoints == 0)
+        return;
+
+    const MinMax *range = &plot->cache->sparklineRanges[iSeries];
+    const char *text = TextFormat("%s%slast = %g, min = %g, max = %g", series->name ? series->name : "", (series->name && series->name[0]) ? ": " : "", 
+                                  series->points[series->numPoints - 1].y, range->minY, range->maxY);
+
+    const Vector2 textSize = MeasureTextEx(*font, text, plot->grid.fontSize, 1);
+    const int padding = 4;
+
+    Rectangle tooltipRect = {pos.x + 2 * padding, pos.y + 2 * padding, textSize.x + 2 * padding, textSize.y + 2 * padding};
+
+    if (tooltipRect.x + tooltipRect.width > GetScreenWidth())
+        tooltipRect.x = pos.x - 2 * padding - tooltipRect.width;
+
+    if (tooltipRect.y + tooltipRect.height > GetScreenHeight())
+        tooltipRect.y = pos.y - 2 * padding - tooltipRect.height;
+
+    DrawRectangleRec(tooltipRect, WHITE);
+    DrawRectangleLinesEx(tooltipRect, 1, *(Color *)&plot->grid.color);
+    drawText(plot, font, text, (Vector2){tooltipRect.x + padding, tooltipRect.y + padding}, 0, plot->grid.fontSize, plot->grid.color);
+}
+
+
+UMPLOT_API void umplotShowSparklines(const Plot *plot, int numCols)
+{
+    beginPlotCall(plot, 1);
+
+    if (numCols <= 0)
+        numCols = 1;
+
+    endOffscreen();
+
+    SetTraceLogLevel(LOG_ERROR);
+    SetConfigFlags(FLAG_WINDOW_RESIZABLE);
+    InitWindow(800, 600, "UmPlot");
+    SetTargetFPS(30);
+
+    canvas = (Rectangle){0, 0, GetScreenWidth(), GetScreenHeight()};
+
+    Font gridFont, titlesFont;
+    getFonts(plot, &gridFont, &titlesFont);
+
+    float scroll = 0;
+    int numScreenshots = 0;
+
+    while (!WindowShouldClose())
+    {
+        const Vector2 pos = GetMousePosition();
+
+        if (IsWindowResized())
+            canvas = (Rectangle){0, 0, GetScreenWidth(), GetScreenHeight()};
+
+        // The columns are recomputed only when the sparkline width changes
+        const Rectangle graphRect = getSparklineGraphRect(plot, getSparklineRect(plot, 0, numCols, 0));
+        const bool ready = updateSparklines(plot, graphRect.width > 1 ? graphRect.width : 1);
+
+        // Scrolling
+        const int numRows = (plot->numSeries + numCols - 1) / numCols;
+        const float maxScroll = numRows * getSparklineRect(plot, 0, numCols, 0).height - GetScreenHeight();
+
+        scroll -= GetMouseWheelMove() * getSparklineRect(plot, 0, numCols, 0).height;
+        if (scroll > maxScroll)  scroll = maxScroll;
+        if (scroll < 0)          scroll = 0;
+
+        // Screenshot
+        const bool screenshotRequested = (IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL)) && IsKeyPressed(KEY_S) && plot->screenshot.fileName && 
+                                         TextLength(plot->screenshot.fileName) > 0 && TextLength(plot->screenshot.fileName) < MAX_SCREENSHOT_FILE_NAME - 16;
+
+        // Draw
+        BeginDrawing();
+        ClearBackground(WHITE);
+
+        if (ready)
+        {
+            beginText(plot);
+            drawSparklines(plot, &gridFont, numCols, scroll);
+            endText(plot);
+        }
+
+        if (screenshotRequested)
+        {
+            // The framebuffer lacks whatever is still queued in the batch
+            rlDrawRenderBatchActive();
+
+            if (queueScreenshot(&screenshotWriter, LoadImageFromScreen(), TextFormat("%s%04d.png", plot->screenshot.fileName, numScreenshots)))
+                numScreenshots++;
+        }
+
+        // Hovered sparkline readout
+        if (ready)
+        {
+            const Rectangle rect = getSparklineRect(plot, 0, numCols, scroll);
+            const int col = pos.x / rect.width;
+            const int row = (pos.y - rect.y) / rect.height;
+            const int iSeries = row * numCols + col;
+
+            if (pos.x >= 0 && pos.y >= 0 && col < numCols && iSeries < plot->numSeries)
+            {
+                beginText(plot);
+                drawSparklineReadout(plot, &gridFont, iSeries, pos);
+                endText(plot);
+            }
+        }
+
+        EndDrawing();
+    }
+
+    finishScreenshots(&screenshotWriter);
+
+    closeWindow();
+}
+
+
+UMPLOT_API void umplotShow(const Plot *plot)
+{
+    umplotShowSubplots(plot, 1, 1, LINK_NONE);
+}
+
+
+UMPLOT_API void umplotShowSubplots(const Plot *plots, int numPlots, int numCols, int link)
+{
+    if (numPlots <= 0)
+        return;
+
+    beginPlotCall(plots, numPlots);
+
+    if (numCols <= 0 || numCols > numPlots)
+        numCols = numPlots;
+
+    Panel *panels = calloc(numPlots, sizeof(Panel));
+    if (!panels)
+        return;
+
+    endOffscreen();
+
+    SetTraceLogLevel(LOG_ERROR);
+    SetConfigFlags(FLAG_WINDOW_RESIZABLE);
     InitWindow(800, 600, "UmPlot");
     SetTargetFPS(30);
 
-    Font gridFont = LoadFontFromMemory(".ttf", liberationFont, sizeof(liberationFont), plot->grid.fontSize, NULL, 256);
-    Font titlesFont = LoadFontFromMemory(".ttf", liberationFont, sizeof(liberationFont), plot->titles.fontSize, NULL, 256);
+    // All panels share the window, its event loop and the process-wide font atlases
+    for (int iPanel = 0; iPanel < numPlots; iPanel++)
+    {
+        Panel *panel = &panels[iPanel];
+
+        panel->plot = &plots[iPanel];
+        panel->rect = canvas = getPanelRect(iPanel, numPlots, numCols);
+        panel->clientRect = getClientRect(panel->plot);
+
+        getFonts(panel->plot, &panel->gridFont, &panel->titlesFont);
+    }
+
+    resetPanels(panels, numPlots, link);
+
+    for (int iPanel = 0; iPanel < numPlots; iPanel++)
+        resetZoomHistory(&panels[iPanel].history, &panels[iPanel].transform);
+
+    const Plot *firstPlot = &plots[0];
+
+    // Panel that receives the current drag, if any
+    int activePanel = -1;
+
+    Rectangle zoomRect = {0};
+    bool showZoomRect = false;
+
+    // Shift + left-drag selects points instead of zooming
+    bool selecting = false, showSelection = false;
+    int selectionPanel = -1;
+    Point selectMinPt, selectMaxPt;
+
+    clearSelection();
+
+    int numScreenshots = 0;
+    bool screenshotPending = false;
+    int framesSinceInput = PREVIEW_IDLE_FRAMES;
+
+    while (!WindowShouldClose())
+    {
+        // Handle input
+        const Vector2 pos = GetMousePosition();
+        const Vector2 delta = GetMouseDelta();
+
+        // Resizing
+        if (IsWindowResized())
+        {
+            for (int iPanel = 0; iPanel < numPlots; iPanel++)
+            {
+                Panel *panel = &panels[iPanel];
+
+                panel->rect = canvas = getPanelRect(iPanel, numPlots, numCols);
+                resizeTransform(panel->plot, &panel->transform, &panel->clientRect);
+                panel->clientRect = getClientRect(panel->plot);
+
+                // Views and layers rendered for the old size are no longer valid
+                resetZoomHistory(&panel->history, &panel->transform);
+                invalidateDataLayers(&panel->layers);
+            }
+
+            framesSinceInput = 0;
+        }
+
+        const int hoveredPanel = getPanelAt(panels, numPlots, pos);
+
+        if (activePanel < 0 && hoveredPanel >= 0 && (IsMouseButtonPressed(MOUSE_BUTTON_LEFT) || IsMouseButtonPressed(MOUSE_BUTTON_RIGHT)) && 
+            CheckCollisionPointRec(pos, panels[hoveredPanel].clientRect))
+            activePanel = hoveredPanel;
+
+        // Zooming
+        if (activePanel >= 0)
+        {
+            Panel *panel = &panels[activePanel];
+            canvas = panel->rect;
+
+            if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT))  
+            {            
+                zoomRect = (Rectangle){pos.x, pos.y, 0, 0};
+                showZoomRect = true;
+                selecting = IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT);
+            }
+
+            if (IsMouseButtonDown(MOUSE_BUTTON_LEFT) && CheckCollisionPointRec(pos, panel->clientRect))  
+            {            
+                zoomRect.width  = pos.x - zoomRect.x;
+                zoomRect.height = pos.y - zoomRect.y;
+            }
+
+            if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT) && selecting)  
+            {
+                const Rectangle selectRect = getNormalizedRect(zoomRect);
+                showSelection = selectRect.width > 0 && selectRect.height > 0;
+
+                if (showSelection)
+                {
+                    // Screen y grows downwards
+                    selectMinPt = getGraphPoint((Vector2){selectRect.x, selectRect.y + selectRect.height}, &panel->transform);
+                    selectMaxPt = getGraphPoint((Vector2){selectRect.x + selectRect.width, selectRect.y}, &panel->transform);
+                    selectPoints(panel->plot, &selectMinPt, &selectMaxPt);
+                    selectionPanel = activePanel;
+                }
+                else
+                    clearSelection();
+
+                showZoomRect = selecting = false;
+            }        
+            else if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT) && showZoomRect)  
+            {            
+                const bool reset = zoomRect.width < 0 || zoomRect.height < 0;
+
+                zoomTransform(panel->plot, &panel->transform, &zoomRect);
+                showZoomRect = false;
+
+                if (reset)
+                    resetPanels(panels, numPlots, link);
+                else
+                    linkPanels(panels, numPlots, activePanel, link);
+
+                pushZoomHistory(&panel->history, &panel->transform);
+            }        
+
+            // Panning
+            if (IsMouseButtonDown(MOUSE_BUTTON_RIGHT) && (delta.x != 0 || delta.y != 0))
+            {    
+                panTransform(panel->plot, &panel->transform, &delta);
+                linkPanels(panels, numPlots, activePanel, link);
+                framesSinceInput = 0;
+            }            
+
+            if (!IsMouseButtonDown(MOUSE_BUTTON_LEFT) && !IsMouseButtonDown(MOUSE_BUTTON_RIGHT))
+                activePanel = -1;
+        }
+
+        if (hoveredPanel >= 0)
+        {
+            Panel *panel = &panels[hoveredPanel];
+            canvas = panel->rect;
+
+            // Zoom history
+            const bool altDown = IsKeyDown(KEY_LEFT_ALT) || IsKeyDown(KEY_RIGHT_ALT);
+            int step = 0;
+
+            if (IsMouseButtonPressed(MOUSE_BUTTON_BACK) || (altDown && IsKeyPressed(KEY_LEFT)) || IsKeyPressed(KEY_BACKSPACE))
+                step = -1;
+
+            if (IsMouseButtonPressed(MOUSE_BUTTON_FORWARD) || (altDown && IsKeyPressed(KEY_RIGHT)))
+                step = 1;
+
+            if (step != 0 && stepZoomHistory(&panel->history, step, &panel->transform))
+                linkPanels(panels, numPlots, hoveredPanel, link);
+
+            // Legend scrolling or wheel zooming
+            const float wheel = GetMouseWheelMove();
+
+            if (wheel != 0 && CheckCollisionPointRec(pos, getLegendRect(panel->plot)))
+                scrollLegend(panel->plot, -3 * wheel * getLegendRowHeight(panel->plot));
+            else if (wheel != 0 && CheckCollisionPointRec(pos, panel->clientRect))
+            {
+                wheelZoomTransform(panel->plot, &panel->transform, &pos, pow(1.2, wheel));
+                linkPanels(panels, numPlots, hoveredPanel, link);
+                framesSinceInput = 0;
+            }
+        }
+
+        // Screenshot: the data layers keep being drawn within the frame budget, and the frame is captured once they are complete
+        if ((IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL)) && IsKeyPressed(KEY_S) && firstPlot->screenshot.fileName && 
+            TextLength(firstPlot->screenshot.fileName) > 0 && TextLength(firstPlot->screenshot.fileName) < MAX_SCREENSHOT_FILE_NAME - 16)
+            screenshotPending = true;
+
+        // Continuous interaction shows a decimated preview, refined once the input has been idle for a few frames
+        const bool preview = framesSinceInput < PREVIEW_IDLE_FRAMES && !screenshotPending;
+        if (framesSinceInput < PREVIEW_IDLE_FRAMES)
+            framesSinceInput++;
+
+        // Panning and wheel zooming are recorded in the history once they settle
+        bool complete = !preview;
+
+        for (int iPanel = 0; iPanel < numPlots; iPanel++)
+        {
+            Panel *panel = &panels[iPanel];
+            canvas = panel->rect;
+            panel->dataLayer = NULL;
+
+            if (!preview)
+            {
+                pushZoomHistory(&panel->history, &panel->transform);
+
+                bool layerComplete;
+                panel->dataLayer = getDataLayer(&panel->layers, panel->plot, &panel->transform, panel->plot->rendering.frameBudget / numPlots, &layerComplete);
+                complete = complete && layerComplete;
+            }
+        }
+
+        const bool screenshotRequested = screenshotPending && complete;
+        if (screenshotRequested)
+            screenshotPending = false;
+
+        // Draw
+        BeginDrawing();
+        ClearBackground(WHITE);
+
+        for (int iPanel = 0; iPanel < numPlots; iPanel++)
+        {
+            Panel *panel = &panels[iPanel];
+            canvas = panel->rect;
+            drawPlot(panel->plot, &panel->transform, &panel->gridFont, &panel->titlesFont, preview, panel->dataLayer);
+        }
+
+        // Only the pixel readback happens on this thread, before any overlays are drawn
+        if (screenshotRequested)
+        {
+            // The framebuffer lacks whatever is still queued in the batch
+            rlDrawRenderBatchActive();
+
+            if (queueScreenshot(&screenshotWriter, LoadImageFromScreen(), TextFormat("%s%04d.png", firstPlot->screenshot.fileName, numScreenshots)))
+                numScreenshots++;
+        }
+
+        // Selection, zoom rectangle or hovered point readout
+        if (showSelection && selectionPanel >= 0)
+        {
+            Panel *panel = &panels[selectionPanel];
+            canvas = panel->rect;
+
+            beginText(panel->plot);
+            drawSelection(panel->plot, &panel->transform, &panel->gridFont, &selectMinPt, &selectMaxPt);
+            endText(panel->plot);
+        }
+
+        if (showZoomRect)
+            drawZoomRect(zoomRect, NULL);
+        else if (hoveredPanel >= 0 && !IsMouseButtonDown(MOUSE_BUTTON_RIGHT))
+        {
+            Panel *panel = &panels[hoveredPanel];
+            canvas = panel->rect;
+
+            beginText(panel->plot);
+            drawHoverPoint(panel->plot, &panel->transform, &panel->gridFont, pos);
+            endText(panel->plot);
+        }
+
+        EndDrawing();
+    }
+
+    finishScreenshots(&screenshotWriter);
+
+    for (int iPanel = 0; iPanel < numPlots; iPanel++)
+        unloadDataLayers(&panels[iPanel].layers);
+
+    free(panels);
+
+    closeWindow();
+}
+
+
+// Images of 4 * width * height bytes must be addressable with int, as raylib does
+static bool isValidImageSize(int width, int height)
+{
+    return width > 0 && height > 0 && width <= INT_MAX / 4 / height;
+}
+
+
+UMPLOT_API int umplotAnimate(const Plot *plot, const char *fileName, int numFrames, int64_t window, int width, int height)
+{
+    if (!isValidImageSize(width, height) || !fileName || numFrames <= 0 || window < 0)
+        return 0;
+
+    beginPlotCall(plot, 1);
+
+    beginOffscreen();
+    canvas = (Rectangle){0, 0, width, height};
+
+    Font gridFont, titlesFont;
+    getFonts(plot, &gridFont, &titlesFont);
+
+    // The whole animation is shown in the full data bounds, so that the decorations never change
+    ScreenTransform transform;
+    resetTransform(plot, &transform);
+
+    RenderTexture2D decorations = LoadRenderTexture(width, height);
+
+    BeginTextureMode(decorations);
+    ClearBackground(WHITE);
+
+    DrawRectangleLinesEx(getClientRect(plot), 1, BLACK);
+
+    int maxYLabelWidth = 0;
+    beginText(plot);
+    drawGrid(plot, &transform, &gridFont, &maxYLabelWidth);
+    drawTitles(plot, &transform, &titlesFont, maxYLabelWidth);
+    drawLegend(plot, &gridFont);
+    endText(plot);
+
+    EndTextureMode();
+
+    // Only the data layer is rendered per frame
+    RenderTexture2D target = LoadRenderTexture(width, height);
+
+    if (decorations.id == 0 || target.id == 0)
+    {
+        if (target.id != 0)
+            UnloadRenderTexture(target);
+        if (decorations.id != 0)
+            UnloadRenderTexture(decorations);
+        return 0;
+    }
+
+    int numWritten = 0;
+
+    for (int frame = 0; frame < numFrames; frame++)
+    {
+        const Animation anim = {frame, numFrames, window};
+
+        BeginTextureMode(target);
+        DrawTextureRec(decorations.texture, (Rectangle){0, 0, width, -height}, (Vector2){0, 0}, WHITE);
+        drawGraph(plot, &transform, &anim, false);
+        EndTextureMode();
+
+        Image image = LoadImageFromTexture(target.texture);
+        ImageFlipVertical(&image);
+
+        if (ExportImage(image, TextFormat("%s%04d.png", fileName, frame)))
+            numWritten++;
+
+        UnloadImage(image);
+    }
+
+    UnloadRenderTexture(target);
+    UnloadRenderTexture(decorations);
+
+    return numWritten;
+}
+
+
+UMPLOT_API bool umplotRender(const Plot *plot, int width, int height, uint8_t *pixels)
+{
+    if (!isValidImageSize(width, height) || !pixels)
+        return false;
+
+    beginPlotCall(plot, 1);
+
+    beginOffscreen();
+    canvas = (Rectangle){0, 0, width, height};
+
+    Font gridFont, titlesFont;
+    getFonts(plot, &gridFont, &titlesFont);
+
+    ScreenTransform transform;
+    resetTransform(plot, &transform);
+
+    RenderTexture2D target = LoadRenderTexture(width, height);
+
+    BeginTextureMode(target);
+    ClearBackground(WHITE);
+    drawPlot(plot, &transform, &gridFont, &titlesFont, false, NULL);
+    EndTextureMode();
+
+    // Render textures are stored bottom-up: flip while copying rather than in a separate pass
+    Image image = LoadImageFromTexture(target.texture);
+
+    const size_t rowSize = 4 * (size_t)width;
+
+    for (int row = 0; row < height; row++)
+        memcpy(&pixels[rowSize * row], &((uint8_t *)image.data)[rowSize * (height - 1 - row)], rowSize);
+
+    UnloadImage(image);
+    UnloadRenderTexture(target);
+
+    return true;
+}
+
+
+UMPLOT_API bool umplotExport(const Plot *plot, const char *fileName, int width, int height)
+{
+    if (!isValidImageSize(width, height) || !fileName)
+        return false;
+
+    beginPlotCall(plot, 1);
+
+    if (IsFileExtension(fileName, ".svg"))
+    {
+        beginOffscreen();
+        canvas = (Rectangle){0, 0, width, height};
+
+        Font gridFont, titlesFont;
+        getFonts(plot, &gridFont, &titlesFont);
+
+        ScreenTransform transform;
+        resetTransform(plot, &transform);
+
+        return writeSvg(plot, &transform, &gridFont, fileName);
+    }
+
+    uint8_t *pixels = malloc(4 * (size_t)width * height);
+    if (!pixels)
+        return false;
+
+    bool ok = umplotRender(plot, width, height, pixels);
+
+    if (ok)
+    {
+        const Image image = {pixels, width, height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+        ok = ExportImage(image, fileName);
+    }
+
+    free(pixels);
+    return ok;
+}
+
+
+UMPLOT_API const int64_t *umplotGetSelection(int64_t iSeries, int64_t *numIndices)
+{
+    if (iSeries < 0 || iSeries >= numSelectionSeries)
+    {
+        *numIndices = 0;
+        return NULL;
+    }
+
+    *numIndices = selection[iSeries].numIndices;
+    return selection[iSeries].indices;
+}
 
-    Rectangle clientRect = getClientRect(plot, api);
-    Rectangle zoomRect = clientRect;
-    bool showZoomRect = false;
-    
-    ScreenTransform transform;
-    resetTransform(plot, &transform, api);    
 
-    while (!WindowShouldClose())
+UMPLOT_API void umplotFreeCache(Plot *plot)
+{
+    freePlotCache(plot->cache);
+    plot->cache = NULL;
+}
+
+
+UMPLOT_API void umplotClose(void)
+{
+    clearSelection();
+    endOffscreen();
+}
+
+
+UMPLOT_API bool umplotHistogramInit(Histogram *hist, int64_t numBins, double min, double max, bool adaptive)
+{
+    // Adaptive histograms merge bins in pairs
+    if (adaptive && numBins % 2 != 0)
+        numBins++;
+
+    *hist = (Histogram){.min = min, .binWidth = (max - min) / numBins, .numBins = numBins, .adaptive = adaptive};
+
+    if (numBins <= 0 || !(max > min))
+        return false;
+
+    hist->counts = calloc(numBins, sizeof(int64_t));
+    return hist->counts != NULL;
+}
+
+
+UMPLOT_API void umplotHistogramAdd(Histogram *hist, const double *values, int64_t numValues)
+{
+    if (!hist->counts || numValues <= 0)
+        return;
+
+    // Adaptive histograms are grown to the range of the whole batch at once
+    if (hist->adaptive)
     {
-        // Handle input
-        const Vector2 pos = GetMousePosition();
-        const Vector2 delta = GetMouseDelta();
+        double min = DBL_MAX, max = -DBL_MAX;
 
-        // Resizing
-        if (IsWindowResized())
+        for (int64_t i = 0; i < numValues; i++)
+            if (isfinite(values[i]))
+            {
+                if (values[i] < min)  min = values[i];
+                if (values[i] > max)  max = values[i];
+            }
+
+        if (min <= max)
+            fitHistogram(hist, min, max);
+    }
+
+    HistogramTask task = {.hist = hist, .values = values, .numValues = numValues, .numTasks = 1};
+
+    if (numValues >= HISTOGRAM_PARALLEL_MIN_VALUES)
+    {
+        task.numTasks = getNumThreads();
+        if (task.numTasks > numValues / HISTOGRAM_PARALLEL_MIN_VALUES)
+            task.numTasks = numValues / HISTOGRAM_PARALLEL_MIN_VALUES;
+    }
+
+    // Small batches, down to single streamed values, are counted in place
+    if (task.numTasks <= 1)
+    {
+        countHistogramValues(hist, values, numValues, hist->counts, &hist->underflow, &hist->overflow);
+        return;
+    }
+
+    task.counts = calloc(task.numTasks * (hist->numBins + 2), sizeof(int64_t));
+    if (!task.counts)
+        return;
+
+    parallelFor(task.numTasks, 1, binHistogramValues, &task);
+
+    for (int iTask = 0; iTask < task.numTasks; iTask++)
+    {
+        const int64_t *counts = &task.counts[iTask * (hist->numBins + 2)];
+
+        for (int64_t iBin = 0; iBin < hist->numBins; iBin++)
+            hist->counts[iBin] += counts[iBin];
+
+        hist->underflow += counts[hist->numBins];
+        hist->overflow += counts[hist->numBins + 1];
+    }
+
+    free(task.counts);
+}
+
+
+UMPLOT_API bool umplotHistogramMerge(Histogram *hist, const Histogram *other)
+{
+    if (!hist->counts || !other->counts)
+        return false;
+
+    if (!hist->adaptive)
+    {
+        if (hist->min != other->min || hist->binWidth != other->binWidth || hist->numBins != other->numBins)
+            return false;
+
+        for (int64_t iBin = 0; iBin < hist->numBins; iBin++)
+            hist->counts[iBin] += other->counts[iBin];
+    }
+    else
+    {
+        // The histogram is grown on a copy, so that a rejected merge leaves it unchanged
+        Histogram grown = *hist;
+
+        grown.counts = malloc(hist->numBins * sizeof(int64_t));
+        if (!grown.counts)
+            return false;
+
+        memcpy(grown.counts, hist->counts, hist->numBins * sizeof(int64_t));
+
+        fitHistogram(&grown, other->min, other->min + other->numBins * other->binWidth - other->binWidth / 2);
+
+        while (grown.numBins >= 2 && grown.binWidth < other->binWidth)
+            expandHistogram(&grown, false);
+
+        // Each bin of the other histogram must fall into a single bin: the bin width must be a multiple of the other one's, 
+        // and the bin edges must be among the other one's edges, as for histograms grown from the same initial range
+        const double widthRatio = grown.binWidth / other->binWidth;
+        const double edgeOffset = (grown.min - other->min) / other->binWidth;
+        const double tolerance = 1e-9;
+
+        const bool aligned = round(widthRatio) >= 1 && fabs(widthRatio - round(widthRatio)) <= tolerance * widthRatio && 
+                             fabs(edgeOffset - round(edgeOffset)) <= tolerance * fmax(1, fabs(edgeOffset));
+
+        if (aligned)
         {
-            resizeTransform(plot, &transform, &clientRect, api);
-            clientRect = zoomRect = getClientRect(plot, api);
+            for (int64_t iBin = 0; iBin < other->numBins; iBin++)
+                if (other->counts[iBin] != 0)
+                    grown.counts[getHistogramBin(&grown, other->min + (iBin + 0.5) * other->binWidth)] += other->counts[iBin];
+
+            memcpy(hist->counts, grown.counts, hist->numBins * sizeof(int64_t));
+            hist->min = grown.min;
+            hist->binWidth = grown.binWidth;
         }
 
-        // Zooming
-        if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT) && CheckCollisionPointRec(pos, clientRect))  
-        {            
-            zoomRect = (Rectangle){pos.x, pos.y, 0, 0};
-            showZoomRect = true;
+        free(grown.counts);
+
+        if (!aligned)
+            return false;
+    }
+
+    hist->underflow += other->underflow;
+    hist->overflow += other->overflow;
+
+    return true;
+}
+
+
+UMPLOT_API void umplotHistogramGetPoints(const Histogram *hist, Point *points)
+{
+    for (int64_t iBin = 0; iBin < hist->numBins; iBin++)
+        points[iBin] = (Point){hist->min + iBin * hist->binWidth, hist->counts[iBin]};
+}
+
+
+UMPLOT_API void umplotHistogramFree(Histogram *hist)
+{
+    free(hist->counts);
+    hist->counts = NULL;
+    hist->numBins = 0;
+}
+
+
+#ifndef UMPLOT_NO_UMKA
+
+// Umka entry points: thin wrappers around the C API
+
+enum
+{
+    MAX_UMKA_PLOT_CACHES = 16
+};
+
+
+// Cache of an Umka plot kept between calls, so that points appended to its series are picked up incrementally. Umka
+// plots are rebuilt on every call, so the cache is identified by the series array, which copies of a plot share. A new 
+// array allocated at the same address is recognized by beginPlotCall() from the sampled data
+typedef struct
+{
+    const void *series;
+    PlotCache *cache;
+    int64_t lastUse;
+} UmkaPlotCache;
+
+
+static UmkaPlotCache umkaPlotCaches[MAX_UMKA_PLOT_CACHES];
+static int64_t numUmkaPlotCacheUses = 0;
+
+
+// Detaches the cache of the series array, if any, so that no other plot of the same call uses it
+static PlotCache *takeUmkaPlotCache(const void *series)
+{
+    if (!series)
+        return NULL;
+
+    for (int i = 0; i < MAX_UMKA_PLOT_CACHES; i++)
+    {
+        if (umkaPlotCaches[i].cache && umkaPlotCaches[i].series == series)
+        {
+            PlotCache *cache = umkaPlotCaches[i].cache;
+            umkaPlotCaches[i] = (UmkaPlotCache){0};
+            return cache;
         }
+    }
+
+    return NULL;
+}
+
 
-        if (IsMouseButtonDown(MOUSE_BUTTON_LEFT) && CheckCollisionPointRec(pos, clientRect))  
-        {            
-            zoomRect.width  = pos.x - zoomRect.x;
-            zoomRect.height = pos.y - zoomRect.y;
+// Keeps the cache for the next call, replacing the least recently used one if there is no free slot
+static void putUmkaPlotCache(const void *series, PlotCache *cache)
+{
+    if (!cache)
+        return;
+
+    int iFree = -1;
+
+    for (int i = 0; i < MAX_UMKA_PLOT_CACHES; i++)
+    {
+        // Another plot of the same call already returned a cache for this series array
+        if (umkaPlotCaches[i].cache && umkaPlotCaches[i].series == series)
+        {
+            freePlotCache(cache);
+            return;
         }
 
-        if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT))  
-        {            
-            zoomTransform(plot, &transform, &zoomRect, api);
-            zoomRect = getClientRect(plot, api);
-            showZoomRect = false;
-        }        
+        if (iFree < 0 || !umkaPlotCaches[i].cache || (umkaPlotCaches[iFree].cache && umkaPlotCaches[i].lastUse < umkaPlotCaches[iFree].lastUse))
+            iFree = i;
+    }
+
+    if (!series)
+    {
+        freePlotCache(cache);
+        return;
+    }
 
-        // Panning
-        if (IsMouseButtonDown(MOUSE_BUTTON_RIGHT) && CheckCollisionPointRec(pos, clientRect))  
-        {    
-            panTransform(plot, &transform, &delta);
-        }            
+    freePlotCache(umkaPlotCaches[iFree].cache);
+    umkaPlotCaches[iFree] = (UmkaPlotCache){.series = series, .cache = cache, .lastUse = ++numUmkaPlotCacheUses};
+}
 
-        // Draw
-        BeginDrawing();
-        ClearBackground(WHITE);
-        
-        // Border
-        DrawRectangleLinesEx(clientRect, 1, BLACK);
 
-        // Grid
-        int maxYLabelWidth = 0;
-        drawGrid(plot, &transform, &gridFont, &maxYLabelWidth, api);
+static Plot getPlotFromUmka(const UmkaPlot *umkaPlot, UmkaAPI *api)
+{
+    Plot plot = {
+        .numSeries = api->umkaGetDynArrayLen(&umkaPlot->series),
+        .grid = umkaPlot->grid,
+        .titles = umkaPlot->titles,
+        .legend = umkaPlot->legend,
+        .screenshot = umkaPlot->screenshot,
+        .fonts = umkaPlot->fonts,
+        .rendering = umkaPlot->rendering,
+        .cache = takeUmkaPlotCache(umkaPlot->series.data)
+    };
+
+    plot.series = calloc(plot.numSeries > 0 ? plot.numSeries : 1, sizeof(Series));
+
+    for (int iSeries = 0; iSeries < plot.numSeries; iSeries++)
+    {
+        const UmkaSeries *umkaSeries = &umkaPlot->series.data[iSeries];
+        Series *series = &plot.series[iSeries];
+
+        series->points = umkaSeries->points.data;
+        series->numPoints = api->umkaGetDynArrayLen(&umkaSeries->points);
+        series->name = umkaSeries->name;
+        series->style = umkaSeries->style;
+
+        const UmkaImageData *umkaImage = &umkaSeries->image;
+        const int64_t numValues = api->umkaGetDynArrayLen(&umkaImage->values);
+
+        series->image = (ImageData){
+            .values = umkaImage->values.data,
+            .numRows = (umkaImage->numCols > 0) ? numValues / umkaImage->numCols : 0,
+            .numCols = umkaImage->numCols,
+            .minValue = umkaImage->minValue,
+            .maxValue = umkaImage->maxValue
+        };
+    }
 
-        // Graph
-        drawGraph(plot, &transform, api);
+    return plot;
+}
 
-        // Titles
-        drawTitles(plot, &transform, &titlesFont, maxYLabelWidth, api);
 
-        // Legend
-        drawLegend(plot, &gridFont, api);
+// The returned histogram shares the counts with the Umka one, the rest is copied back with putHistogramToUmka()
+static Histogram getHistogramFromUmka(const UmkaHistogram *umkaHist, UmkaAPI *api)
+{
+    return (Histogram){
+        .min = umkaHist->min,
+        .binWidth = umkaHist->binWidth,
+        .counts = umkaHist->counts.data,
+        .numBins = api->umkaGetDynArrayLen(&umkaHist->counts),
+        .underflow = umkaHist->underflow,
+        .overflow = umkaHist->overflow,
+        .adaptive = umkaHist->adaptive
+    };
+}
 
-        // Zoom rectangle
-        if (showZoomRect)
-            drawZoomRect(zoomRect, &transform);
 
-        EndDrawing();
+static void putHistogramToUmka(const Histogram *hist, UmkaHistogram *umkaHist)
+{
+    umkaHist->min = hist->min;
+    umkaHist->binWidth = hist->binWidth;
+    umkaHist->underflow = hist->underflow;
+    umkaHist->overflow = hist->overflow;
+}
+
+
+static void freePlotFromUmka(Plot *plot, const UmkaPlot *umkaPlot)
+{
+    putUmkaPlotCache(umkaPlot->series.data, plot->cache);
+    plot->cache = NULL;
+
+    free(plot->series);
+    plot->series = NULL;
+    plot->numSeries = 0;
+}
+
+
+UMPLOT_API void umplot_plot(UmkaStackSlot *params, UmkaStackSlot *result)
+{
+    UmkaPlot *umkaPlot = (UmkaPlot *) params[0].ptrVal;
+
+    void *umka = result->ptrVal;
+    UmkaAPI *api = umkaGetAPI(umka);
+
+    Plot plot = getPlotFromUmka(umkaPlot, api);
+    umplotShow(&plot);
+    freePlotFromUmka(&plot, umkaPlot);
+
+    result->intVal = 1;
+}
+
+
+UMPLOT_API void umplot_subplots(UmkaStackSlot *params, UmkaStackSlot *result)
+{
+    // Umka passes parameters in reverse order
+    UmkaDynArray(UmkaPlot) *umkaPlots = params[2].ptrVal;
+    const int numCols = params[1].intVal;
+    const int link = params[0].intVal;
+
+    void *umka = result->ptrVal;
+    UmkaAPI *api = umkaGetAPI(umka);
+
+    const int numPlots = api->umkaGetDynArrayLen(umkaPlots);
+
+    Plot *plots = calloc(numPlots > 0 ? numPlots : 1, sizeof(Plot));
+    if (!plots)
+    {
+        result->intVal = 0;
+        return;
     }
 
-    CloseWindow();
+    for (int iPlot = 0; iPlot < numPlots; iPlot++)
+        plots[iPlot] = getPlotFromUmka(&umkaPlots->data[iPlot], api);
+
+    umplotShowSubplots(plots, numPlots, numCols, link);
+
+    for (int iPlot = 0; iPlot < numPlots; iPlot++)
+        freePlotFromUmka(&plots[iPlot], &umkaPlots->data[iPlot]);
+
+    free(plots);
+    result->intVal = 1;
+}
+
+
+UMPLOT_API void umplot_sparklines(UmkaStackSlot *params, UmkaStackSlot *result)
+{
+    // Umka passes parameters in reverse order
+    UmkaPlot *umkaPlot = (UmkaPlot *) params[1].ptrVal;
+    const int numCols = params[0].intVal;
+
+    void *umka = result->ptrVal;
+    UmkaAPI *api = umkaGetAPI(umka);
+
+    Plot plot = getPlotFromUmka(umkaPlot, api);
+    umplotShowSparklines(&plot, numCols);
+    freePlotFromUmka(&plot, umkaPlot);
+
+    result->intVal = 1;
+}
+
+
+UMPLOT_API void umplot_freeCache(UmkaStackSlot *params, UmkaStackSlot *result)
+{
+    UmkaPlot *umkaPlot = (UmkaPlot *) params[0].ptrVal;
+
+    freePlotCache(takeUmkaPlotCache(umkaPlot->series.data));
+
+    result->intVal = 1;
+}
+
+
+UMPLOT_API void umplot_selectionLen(UmkaStackSlot *params, UmkaStackSlot *result)
+{
+    const int64_t iSeries = params[0].intVal;
+
+    int64_t numIndices;
+    umplotGetSelection(iSeries, &numIndices);
+
+    result->intVal = numIndices;
+}
+
+
+UMPLOT_API void umplot_selection(UmkaStackSlot *params, UmkaStackSlot *result)
+{
+    // Umka passes parameters in reverse order
+    const int64_t iSeries = params[1].intVal;
+    UmkaDynArray(int64_t) *indices = params[0].ptrVal;
+
+    void *umka = result->ptrVal;
+    UmkaAPI *api = umkaGetAPI(umka);
+
+    int64_t numIndices;
+    const int64_t *selected = umplotGetSelection(iSeries, &numIndices);
+
+    if (api->umkaGetDynArrayLen(indices) < numIndices)
+    {
+        result->intVal = 0;
+        return;
+    }
+
+    if (numIndices > 0)
+        memcpy(indices->data, selected, numIndices * sizeof(int64_t));
+
+    result->intVal = 1;
+}
+
+
+UMPLOT_API void umplot_animate(UmkaStackSlot *params, UmkaStackSlot *result)
+{
+    // Umka passes parameters in reverse order
+    UmkaPlot *umkaPlot = (UmkaPlot *) params[5].ptrVal;
+    const char *fileName = (const char *) params[4].ptrVal;
+    const int numFrames = params[3].intVal;
+    const int64_t window = params[2].intVal;
+    const int width = params[1].intVal;
+    const int height = params[0].intVal;
+
+    void *umka = result->ptrVal;
+    UmkaAPI *api = umkaGetAPI(umka);
+
+    Plot plot = getPlotFromUmka(umkaPlot, api);
+    result->intVal = umplotAnimate(&plot, fileName, numFrames, window, width, height);
+    freePlotFromUmka(&plot, umkaPlot);
+}
+
+
+UMPLOT_API void umplot_render(UmkaStackSlot *params, UmkaStackSlot *result)
+{
+    // Umka passes parameters in reverse order
+    UmkaPlot *umkaPlot = (UmkaPlot *) params[3].ptrVal;
+    const int64_t width = params[2].intVal;
+    const int64_t height = params[1].intVal;
+    UmkaDynArray(uint8_t) *pixels = params[0].ptrVal;
+
+    void *umka = result->ptrVal;
+    UmkaAPI *api = umkaGetAPI(umka);
+
+    // Umka integers are 64-bit: the dimensions are checked before narrowing them for umplotRender()
+    if (width <= 0 || height <= 0 || width > INT_MAX / 4 / height || api->umkaGetDynArrayLen(pixels) < 4 * width * height)
+    {
+        result->intVal = 0;
+        return;
+    }
+
+    Plot plot = getPlotFromUmka(umkaPlot, api);
+    result->intVal = umplotRender(&plot, width, height, pixels->data);
+    freePlotFromUmka(&plot, umkaPlot);
+}
+
+
+UMPLOT_API void umplot_export(UmkaStackSlot *params, UmkaStackSlot *result)
+{
+    // Umka passes parameters in reverse order
+    UmkaPlot *umkaPlot = (UmkaPlot *) params[3].ptrVal;
+    const char *fileName = (const char *) params[2].ptrVal;
+    const int width = params[1].intVal;
+    const int height = params[0].intVal;
+
+    void *umka = result->ptrVal;
+    UmkaAPI *api = umkaGetAPI(umka);
+
+    Plot plot = getPlotFromUmka(umkaPlot, api);
+    result->intVal = umplotExport(&plot, fileName, width, height);
+    freePlotFromUmka(&plot, umkaPlot);
+}
+
+UMPLOT_API void umplot_histogramAdd(UmkaStackSlot *params, UmkaStackSlot *result)
+{
+    // Umka passes parameters in reverse order
+    UmkaHistogram *umkaHist = params[1].ptrVal;
+    UmkaDynArray(double) *values = params[0].ptrVal;
+
+    void *umka = result->ptrVal;
+    UmkaAPI *api = umkaGetAPI(umka);
+
+    Histogram hist = getHistogramFromUmka(umkaHist, api);
+    umplotHistogramAdd(&hist, values->data, api->umkaGetDynArrayLen(values));
+    putHistogramToUmka(&hist, umkaHist);
+
+    result->intVal = 1;
+}
+
+
+UMPLOT_API void umplot_histogramAddValue(UmkaStackSlot *params, UmkaStackSlot *result)
+{
+    // Umka passes parameters in reverse order
+    UmkaHistogram *umkaHist = params[1].ptrVal;
+    const double value = params[0].realVal;
+
+    void *umka = result->ptrVal;
+    UmkaAPI *api = umkaGetAPI(umka);
+
+    Histogram hist = getHistogramFromUmka(umkaHist, api);
+    umplotHistogramAdd(&hist, &value, 1);
+    putHistogramToUmka(&hist, umkaHist);
+
     result->intVal = 1;
 }
+
+
+UMPLOT_API void umplot_histogramMerge(UmkaStackSlot *params, UmkaStackSlot *result)
+{
+    // Umka passes parameters in reverse order
+    UmkaHistogram *umkaHist = params[1].ptrVal;
+    const UmkaHistogram *umkaOther = params[0].ptrVal;
+
+    void *umka = result->ptrVal;
+    UmkaAPI *api = umkaGetAPI(umka);
+
+    Histogram hist = getHistogramFromUmka(umkaHist, api);
+    const Histogram other = getHistogramFromUmka(umkaOther, api);
+
+    result->intVal = umplotHistogramMerge(&hist, &other);
+    putHistogramToUmka(&hist, umkaHist);
+}
+
+#endif
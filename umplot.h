@@ -0,0 +1,210 @@
+#ifndef UMPLOT_H_INCLUDED
+#define UMPLOT_H_INCLUDED
+
+// UmPlot C API: build umplot.c with UMPLOT_NO_UMKA defined to use the plotting engine without Umka
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#ifdef _WIN32
+    #define UMPLOT_API __declspec(dllexport)
+#else
+    #define UMPLOT_API __attribute__((visibility("default")))
+#endif
+
+
+enum
+{
+    STYLE_LINE = 1,
+    STYLE_SCATTER,
+    STYLE_DENSITY,      // Scatter drawn as a colormapped 2D histogram with a bin per pixel
+    STYLE_LINE_DENSITY, // Lines drawn together with all other such series as a colormapped count of the series crossing each pixel
+    STYLE_SPLAT,        // Scatter drawn into an image on the CPU by all cores, for tens of millions of points
+    STYLE_HISTOGRAM,    // Bars with a point per bin: the left edge and the count
+    STYLE_IMAGE         // Colormapped matrix of values stretched over the rectangle between the first two points
+};
+
+
+// Axes shared by subplots
+enum
+{
+    LINK_NONE = 0,
+    LINK_X = 1,
+    LINK_Y = 2,
+    LINK_XY = LINK_X | LINK_Y
+};
+
+
+typedef struct
+{
+    double x, y;
+} Point;
+
+
+typedef struct
+{
+    int64_t kind;
+    uint32_t color;     // 0xAABBGGRR
+    double width;
+} Style;
+
+
+// Matrix of values shown by series with the image style, row 0 on top
+typedef struct
+{
+    double *values;             // numRows * numCols, row by row, NaN for no value
+    int64_t numRows, numCols;
+    double minValue, maxValue;  // Mapped to the ends of the colormap, the range of the values if minValue >= maxValue
+} ImageData;
+
+
+typedef struct
+{
+    Point *points;
+    int64_t numPoints;
+    char *name;
+    Style style;
+    ImageData image;
+} Series;
+
+
+typedef struct
+{
+    int64_t xNumLines, yNumLines;
+    uint32_t color;
+    int64_t fontSize;
+    bool visible, labelled;
+} Grid;
+
+
+typedef struct
+{
+    char *x, *y, *graph;
+    uint32_t color;
+    int64_t fontSize;
+    bool visible;
+} Titles;
+
+
+typedef struct
+{
+    bool visible;
+    bool grouped;       // Show consecutive series with equal names and styles as a single entry
+} Legend;
+
+
+typedef struct
+{
+    char *fileName;
+} Screenshot;
+
+
+typedef struct
+{
+    bool sdf;           // Render all text sizes from a single signed distance field atlas
+} Fonts;
+
+
+typedef struct
+{
+    double frameBudget;     // Milliseconds per frame spent on drawing the data in the window, 0 for no limit
+} Rendering;
+
+
+// Counts of values in numBins equal bins starting at min. Adaptive histograms double the bin width, merging neighboring
+// bins, to take in values outside the range, fixed ones count them as underflow or overflow
+typedef struct
+{
+    double min, binWidth;
+    int64_t *counts;
+    int64_t numBins;
+    int64_t underflow, overflow;
+    bool adaptive;
+} Histogram;
+
+
+// Derived data kept between calls, such as measured legend labels and series level-of-detail pyramids. At every call,
+// the data of each series is compared with a few evenly spaced samples taken at the previous call: points appended to
+// a series are picked up incrementally, and the derived data of series whose samples have changed are rebuilt. Changes
+// in place that leave all samples intact are not noticed and require umplotFreeCache(). Umka plots keep their caches
+// in UmPlot, identified by the series array, with the same checks, and release them with Plot.freeCache()
+typedef struct PlotCache PlotCache;
+
+
+typedef struct
+{
+    Series *series;
+    int64_t numSeries;
+    Grid grid;
+    Titles titles;
+    Legend legend;
+    Screenshot screenshot;
+    Fonts fonts;
+    Rendering rendering;
+    PlotCache *cache;   // Managed by UmPlot: initialize to NULL and release with umplotFreeCache()
+} Plot;
+
+
+// Fills in the same defaults as init() in umplot.um; the series array is owned by the caller
+UMPLOT_API void umplotInit(Plot *plot, Series *series, int64_t numSeries, int64_t kind);
+
+// Opens an interactive window and returns when it is closed
+UMPLOT_API void umplotShow(const Plot *plot);
+
+// Opens a window with a grid of subplots, numCols per row, and returns when it is closed. Zooming or panning a subplot
+// applies the same range along the linked axes to all others
+UMPLOT_API void umplotShowSubplots(const Plot *plots, int numPlots, int numCols, int link);
+
+// Opens a window with a grid of sparklines, one per series, numCols per row, and returns when it is closed
+UMPLOT_API void umplotShowSparklines(const Plot *plot, int numCols);
+
+// Returns the indices of the points of the series selected with Shift + left-drag when the window was last closed (for
+// subplots, of the subplot selected last), in ascending order for series sorted by x and in no particular order otherwise
+UMPLOT_API const int64_t *umplotGetSelection(int64_t iSeries, int64_t *numIndices);
+
+// Writes numFrames frames of growing series (or sliding windows of window points) to fileName0000.png, fileName0001.png, ...
+// Returns the number of frames written, 0 for invalid arguments
+UMPLOT_API int umplotAnimate(const Plot *plot, const char *fileName, int numFrames, int64_t window, int width, int height);
+
+// Renders into a buffer of width * height RGBA pixels, top row first. Returns false unless width and height are positive
+// and 4 * width * height fits into int
+UMPLOT_API bool umplotRender(const Plot *plot, int width, int height, uint8_t *pixels);
+
+// Writes a PNG or SVG file, depending on the file name extension
+UMPLOT_API bool umplotExport(const Plot *plot, const char *fileName, int width, int height);
+
+// Releases the data cached for the plot, e.g. before the plot itself is freed
+UMPLOT_API void umplotFreeCache(Plot *plot);
+
+// Releases the hidden window used as a graphics context by the offscreen functions
+UMPLOT_API void umplotClose(void);
+
+// Allocates the bins of a histogram covering [min, max), rounding numBins up to even for adaptive ones
+UMPLOT_API bool umplotHistogramInit(Histogram *hist, int64_t numBins, double min, double max, bool adaptive);
+
+// Counts a batch of values, in parallel for large batches. NaNs are ignored
+UMPLOT_API void umplotHistogramAdd(Histogram *hist, const double *values, int64_t numValues);
+
+// Adds the counts of another histogram, e.g. filled by another thread. Fixed histograms must have the same bins, adaptive 
+// ones are grown to take in the other one's range and then must have each bin of the other one inside a single bin, which 
+// holds for histograms created with the same range and number of bins. Returns false and leaves the histogram unchanged 
+// if the bins do not align
+UMPLOT_API bool umplotHistogramMerge(Histogram *hist, const Histogram *other);
+
+// Writes numBins points for a series with the histogram style
+UMPLOT_API void umplotHistogramGetPoints(const Histogram *hist, Point *points);
+
+UMPLOT_API void umplotHistogramFree(Histogram *hist);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,141 @@
+// Build step: rasterizes the Latin-1 range of the embedded Liberation font at the given sizes and writes the atlases
+// with glyph metrics as C source, so that umplot.c built with UMPLOT_BAKED_FONT needs no TTF rasterization at runtime
+//
+// Usage: umplot_bake_font <output header> <size> [size ...]
+//
+// Atlases are stored as 8-bit alpha, with runs of zeros encoded as a zero byte followed by the run length
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "raylib.h"
+#include "font.h"
+
+
+enum
+{
+    FIRST_CODEPOINT = 32,
+    LAST_CODEPOINT = 255,
+    GLYPH_COUNT = LAST_CODEPOINT - FIRST_CODEPOINT + 1,
+    GLYPH_PADDING = 4
+};
+
+
+static void writeBytes(FILE *file, const unsigned char *data, int size)
+{
+    for (int i = 0; i < size; i++)
+        fprintf(file, "%s0x%02X,", (i % 32 == 0) ? "\n    " : " ", data[i]);
+    fprintf(file, "\n");
+}
+
+
+static int encodeAlpha(const Image *atlas, unsigned char *encoded)
+{
+    const unsigned char *pixels = atlas->data;
+    const int numPixels = atlas->width * atlas->height;
+    int size = 0;
+
+    for (int i = 0; i < numPixels; )
+    {
+        // Gray-alpha pixels: the alpha byte carries the coverage
+        const unsigned char alpha = pixels[2 * i + 1];
+
+        if (alpha == 0)
+        {
+            int run = 0;
+            while (i < numPixels && pixels[2 * i + 1] == 0 && run < 255)
+            {
+                run++;
+                i++;
+            }
+
+            encoded[size++] = 0;
+            encoded[size++] = run;
+        }
+        else
+        {
+            encoded[size++] = alpha;
+            i++;
+        }
+    }
+
+    return size;
+}
+
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "Usage: umplot_bake_font <output header> <size> [size ...]\n");
+        return 1;
+    }
+
+    FILE *file = fopen(argv[1], "w");
+    if (!file)
+    {
+        fprintf(stderr, "Cannot write %s\n", argv[1]);
+        return 1;
+    }
+
+    SetTraceLogLevel(LOG_ERROR);
+
+    int codepoints[GLYPH_COUNT];
+    for (int i = 0; i < GLYPH_COUNT; i++)
+        codepoints[i] = FIRST_CODEPOINT + i;
+
+    const int numSizes = argc - 2;
+    int *atlasWidths = malloc(numSizes * sizeof(int));
+    int *atlasHeights = malloc(numSizes * sizeof(int));
+
+    fprintf(file, "// Generated by umplot_bake_font from the Liberation Sans Serif font, do not edit\n");
+    fprintf(file, "// License: https://github.com/liberationfonts/liberation-fonts/blob/main/LICENSE\n\n");
+
+    for (int iSize = 0; iSize < numSizes; iSize++)
+    {
+        const int size = atoi(argv[iSize + 2]);
+
+        GlyphInfo *glyphs = LoadFontData(liberationFont, sizeof(liberationFont), size, codepoints, GLYPH_COUNT, FONT_DEFAULT);
+        Rectangle *recs = NULL;
+        Image atlas = GenImageFontAtlas(glyphs, &recs, GLYPH_COUNT, size, GLYPH_PADDING, 0);
+
+        ImageFormat(&atlas, PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA);
+
+        atlasWidths[iSize] = atlas.width;
+        atlasHeights[iSize] = atlas.height;
+
+        // Worst case: every pixel is a single zero run
+        unsigned char *encoded = malloc(2 * atlas.width * atlas.height);
+        const int encodedSize = encodeAlpha(&atlas, encoded);
+
+        fprintf(file, "static const unsigned char bakedAtlas%d[%d] = {", size, encodedSize);
+        writeBytes(file, encoded, encodedSize);
+        fprintf(file, "};\n\n");
+
+        fprintf(file, "static const BakedGlyph bakedGlyphs%d[%d] = {\n", size, GLYPH_COUNT);
+        for (int i = 0; i < GLYPH_COUNT; i++)
+            fprintf(file, "    {%d, %d, %d, %d, %d, %d, %d, %d},\n", glyphs[i].value, glyphs[i].offsetX, glyphs[i].offsetY, glyphs[i].advanceX,
+                    (int)recs[i].x, (int)recs[i].y, (int)recs[i].width, (int)recs[i].height);
+        fprintf(file, "};\n\n");
+
+        free(encoded);
+        UnloadImage(atlas);
+        MemFree(recs);
+        UnloadFontData(glyphs, GLYPH_COUNT);
+    }
+
+    fprintf(file, "static const BakedFont bakedFonts[%d] = {\n", numSizes);
+    for (int iSize = 0; iSize < numSizes; iSize++)
+    {
+        const int size = atoi(argv[iSize + 2]);
+        fprintf(file, "    {%d, %d, %d, %d, %d, sizeof(bakedAtlas%d), bakedAtlas%d, bakedGlyphs%d},\n", 
+                size, GLYPH_COUNT, GLYPH_PADDING, atlasWidths[iSize], atlasHeights[iSize], size, size, size);
+    }
+    fprintf(file, "};\n");
+
+    free(atlasWidths);
+    free(atlasHeights);
+
+    fclose(file);
+    return 0;
+}
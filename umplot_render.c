@@ -0,0 +1,323 @@
+// Standalone renderer: reads a plot description and data files and writes a PNG or SVG image without the Umka interpreter
+//
+// Usage: umplot_render <description> <output.png | output.svg> [width height]
+//
+// The description has one directive per line, '#' starts a comment line:
+//     title <text>
+//     xtitle <text>
+//     ytitle <text>
+//     grid <xNumLines> <yNumLines>
+//     fontsize <size>
+//     legend on | off
+//     series <data file> [line | scatter | density | linedensity | splat | histogram] [width] [color as 0xAABBGGRR] [name]
+//
+// The series fields are positional: a field can only be given after all the preceding ones, and "-" keeps the default,
+// e.g. "series data.csv - - - Temperature" names a line series of the default width and color.
+//
+// Data file paths are relative to the description. A *.bin file holds native doubles x0, y0, x1, y1, ...
+// Any other file is text with one "x, y" or "y" pair per line (comma, semicolon or whitespace separated); lines that
+// do not start with a number are skipped.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "raylib.h"
+#include "umplot.h"
+
+
+enum
+{
+    MAX_SERIES = 1024
+};
+
+
+static Plot plot;
+static Series series[MAX_SERIES];
+
+
+static void initPlot()
+{
+    // Defaults for all possible series, numSeries grows as the description is parsed
+    umplotInit(&plot, series, MAX_SERIES, STYLE_LINE);
+    plot.numSeries = 0;
+}
+
+
+static bool copyString(char **dest, const char *str)
+{
+    char *copy = malloc(strlen(str) + 1);
+    if (!copy)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return false;
+    }
+
+    strcpy(copy, str);
+    *dest = copy;
+    return true;
+}
+
+
+static bool isDefaultField(const char *field)
+{
+    return *field == 0 || strcmp(field, "-") == 0;
+}
+
+
+static char *skipSpaces(char *str)
+{
+    while (*str == ' ' || *str == '\t')
+        str++;
+    return str;
+}
+
+
+static char *getToken(char **str)
+{
+    char *token = skipSpaces(*str);
+    char *end = token;
+
+    while (*end && *end != ' ' && *end != '\t')
+        end++;
+
+    *str = *end ? end + 1 : end;
+    *end = 0;
+    return token;
+}
+
+
+static bool addPoint(Series *series, int64_t *capacity, Point pt)
+{
+    if (series->numPoints == *capacity)
+    {
+        *capacity = *capacity ? 2 * *capacity : 1024;
+
+        Point *points = realloc(series->points, *capacity * sizeof(Point));
+        if (!points)
+            return false;
+
+        series->points = points;
+    }
+
+    series->points[series->numPoints++] = pt;
+    return true;
+}
+
+
+static bool loadBinaryData(Series *series, const char *fileName)
+{
+    unsigned int size = 0;
+    unsigned char *data = LoadFileData(fileName, &size);
+    if (!data)
+        return false;
+
+    series->numPoints = size / sizeof(Point);
+    series->points = malloc((series->numPoints > 0 ? series->numPoints : 1) * sizeof(Point));
+
+    if (series->points)
+        memcpy(series->points, data, series->numPoints * sizeof(Point));
+
+    UnloadFileData(data);
+    return series->points != NULL;
+}
+
+
+static bool loadTextData(Series *series, const char *fileName)
+{
+    char *text = LoadFileText(fileName);
+    if (!text)
+        return false;
+
+    int64_t capacity = 0;
+    bool ok = true;
+
+    for (char *line = text, *next; line && *line && ok; line = next)
+    {
+        next = strchr(line, '\n');
+        if (next)
+            *next++ = 0;
+
+        char *end;
+        const double first = strtod(line, &end);
+        if (end == line)
+            continue;
+
+        while (*end == ',' || *end == ';' || *end == ' ' || *end == '\t')
+            end++;
+
+        char *secondEnd;
+        const double second = strtod(end, &secondEnd);
+
+        if (secondEnd == end)
+            ok = addPoint(series, &capacity, (Point){series->numPoints, first});
+        else
+            ok = addPoint(series, &capacity, (Point){first, second});
+    }
+
+    UnloadFileText(text);
+    return ok;
+}
+
+
+static bool parseSeries(char *args, const char *dir)
+{
+    if (plot.numSeries >= MAX_SERIES)
+    {
+        fprintf(stderr, "Too many series\n");
+        return false;
+    }
+
+    Series *s = &series[plot.numSeries];
+
+    const char *fileName = getToken(&args);
+
+    // The kind is checked before the data file is read
+    const char *kind = getToken(&args);
+    if (isDefaultField(kind) || strcmp(kind, "line") == 0)
+        s->style.kind = STYLE_LINE;
+    else if (strcmp(kind, "scatter") == 0)
+        s->style.kind = STYLE_SCATTER;
+    else if (strcmp(kind, "density") == 0)
+        s->style.kind = STYLE_DENSITY;
+    else if (strcmp(kind, "linedensity") == 0)
+        s->style.kind = STYLE_LINE_DENSITY;
+    else if (strcmp(kind, "splat") == 0)
+        s->style.kind = STYLE_SPLAT;
+    else if (strcmp(kind, "histogram") == 0)
+        s->style.kind = STYLE_HISTOGRAM;
+    else
+    {
+        fprintf(stderr, "Unknown series kind %s\n", kind);
+        return false;
+    }
+
+    const bool absolute = fileName[0] == '/' || fileName[0] == '\\' || (fileName[0] && fileName[1] == ':');
+
+    char path[2048];
+    if (absolute)
+        snprintf(path, sizeof(path), "%s", fileName);
+    else
+        snprintf(path, sizeof(path), "%s/%s", dir, fileName);
+
+    const bool ok = IsFileExtension(path, ".bin") ? loadBinaryData(s, path) : loadTextData(s, path);
+    if (!ok)
+    {
+        fprintf(stderr, "Cannot read data file %s\n", path);
+        return false;
+    }
+
+    const char *width = getToken(&args);
+    if (!isDefaultField(width))
+        s->style.width = strtod(width, NULL);
+
+    const char *color = getToken(&args);
+    if (!isDefaultField(color))
+        s->style.color = strtoul(color, NULL, 0);
+
+    if (!copyString(&s->name, skipSpaces(args)))
+        return false;
+
+    plot.numSeries++;
+    return true;
+}
+
+
+static bool parseDescription(const char *fileName)
+{
+    char *text = LoadFileText(fileName);
+    if (!text)
+    {
+        fprintf(stderr, "Cannot read description file %s\n", fileName);
+        return false;
+    }
+
+    char dir[1024];
+    snprintf(dir, sizeof(dir), "%s", GetDirectoryPath(fileName));
+
+    if (dir[0] == 0)
+        TextCopy(dir, ".");
+
+    bool ok = true;
+
+    for (char *line = text, *next; line && *line && ok; line = next)
+    {
+        next = strchr(line, '\n');
+        if (next)
+            *next++ = 0;
+
+        char *end = line + strlen(line);
+        while (end > line && (end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t'))
+            *--end = 0;
+
+        char *args = skipSpaces(line);
+        if (*args == 0 || *args == '#')
+            continue;
+
+        const char *directive = getToken(&args);
+        args = skipSpaces(args);
+
+        if (strcmp(directive, "title") == 0)
+            ok = copyString(&plot.titles.graph, args);
+        else if (strcmp(directive, "xtitle") == 0)
+            ok = copyString(&plot.titles.x, args);
+        else if (strcmp(directive, "ytitle") == 0)
+            ok = copyString(&plot.titles.y, args);
+        else if (strcmp(directive, "grid") == 0)
+        {
+            plot.grid.xNumLines = strtol(getToken(&args), NULL, 10);
+            plot.grid.yNumLines = strtol(getToken(&args), NULL, 10);
+        }
+        else if (strcmp(directive, "fontsize") == 0)
+            plot.grid.fontSize = plot.titles.fontSize = strtol(args, NULL, 10);
+        else if (strcmp(directive, "legend") == 0)
+            plot.legend.visible = strcmp(args, "off") != 0;
+        else if (strcmp(directive, "series") == 0)
+            ok = parseSeries(args, dir);
+        else
+        {
+            fprintf(stderr, "Unknown directive %s\n", directive);
+            ok = false;
+        }
+    }
+
+    UnloadFileText(text);
+    return ok;
+}
+
+
+int main(int argc, char **argv)
+{
+    if (argc != 3 && argc != 5)
+    {
+        fprintf(stderr, "Usage: umplot_render <description> <output.png | output.svg> [width height]\n");
+        return 1;
+    }
+
+    // Sizes out of the int range are rejected here, the others by umplotExport()
+    const long width  = (argc == 5) ? strtol(argv[3], NULL, 10) : 800;
+    const long height = (argc == 5) ? strtol(argv[4], NULL, 10) : 600;
+
+    if (width <= 0 || height <= 0 || width > INT_MAX || height > INT_MAX)
+    {
+        fprintf(stderr, "Invalid image size %s x %s\n", argv[3], argv[4]);
+        return 1;
+    }
+
+    initPlot();
+
+    if (!parseDescription(argv[1]))
+        return 1;
+
+    const bool ok = umplotExport(&plot, argv[2], width, height);
+    umplotClose();
+
+    if (!ok)
+    {
+        fprintf(stderr, "Cannot write %s\n", argv[2]);
+        return 1;
+    }
+
+    return 0;
+}